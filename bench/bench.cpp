@@ -0,0 +1,294 @@
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "symbol-resolver.hpp"
+#include "type-checker.hpp"
+#include "code-generator.hpp"
+#include "memory.hpp"
+#include "assembler.hpp"
+#include "virtual-machine.hpp"
+#include "output.hpp"
+#include "thread-pool.hpp"
+#include "json.hpp"
+#include "options.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+/* Times every phase of compiling and running a set of workloads: the given
+   files, and programs generated to stress the front-end and the VM.
+
+   usage: bench [--runs n] [--json path] [--label name] [files...] */
+
+using Clock = std::chrono::steady_clock;
+
+static char const *const Phases[] = {
+    "lex", "parse", "resolve", "typecheck", "codegen", "assemble", "execute"
+};
+
+static constexpr std::size_t PhaseCount = sizeof(Phases) / sizeof(Phases[0]);
+
+struct Workload {
+    std::string name;
+    std::string path;
+
+    /* Milliseconds of every run, per phase */
+    std::vector<double> times[PhaseCount];
+
+    uint64_t steps;
+};
+
+/* Many functions of locals, loops, branches and calls, for the front-end */
+static std::string write_functions(std::string const &dir, int functions) {
+    std::stringstream ss;
+
+    for (int i = 0; i < functions; i++) {
+        ss << "function f" << i << "(n: int, m: int) -> int {\n"
+           << "    total: int = 0;\n"
+           << "    values: int[4];\n"
+           << "    i: int = 0;\n"
+           << "    while i < n and total < 1000 {\n"
+           << "        values[i & 3] = i * m + " << i << ";\n"
+           << "        if i % 3 == 0 or not (m > 2) {\n"
+           << "            total = total + values[i & 3];\n"
+           << "        } else {\n"
+           << "            total = total - (i >> 1 | 1);\n"
+           << "        }\n"
+           << "        i = i + 1;\n"
+           << "    }\n";
+
+        if (i + 1 < functions) {
+            ss << "    return total + f" << i + 1 << "(n, m);\n";
+        } else {
+            ss << "    return total;\n";
+        }
+        ss << "}\n\n";
+    }
+    ss << "print(f0(8, 3));\n";
+
+    std::string path = dir + "/pix-bench-functions.pix";
+    std::ofstream(path) << ss.str();
+    return path;
+}
+
+/* A long-running loop of arithmetic and memory accesses, for the VM */
+static std::string write_loop(std::string const &dir, int iterations) {
+    std::stringstream ss;
+
+    ss << "function run(n: int) -> int {\n"
+       << "    table: int[256];\n"
+       << "    hash: int = 0;\n"
+       << "    i: int = 0;\n"
+       << "    while i < n {\n"
+       << "        hash = (hash ^ i) * 31 + table[hash & 255];\n"
+       << "        table[i & 255] = hash;\n"
+       << "        i = i + 1;\n"
+       << "    }\n"
+       << "    return hash;\n"
+       << "}\n\n"
+       << "print(run(" << iterations << "));\n";
+
+    std::string path = dir + "/pix-bench-loop.pix";
+    std::ofstream(path) << ss.str();
+    return path;
+}
+
+static double since(Clock::time_point &start) {
+    Clock::time_point now = Clock::now();
+    double ms = std::chrono::duration<double, std::milli>(now - start).count();
+
+    start = now;
+    return ms;
+}
+
+static void run(Workload &workload, ThreadPool &pool) {
+    Memory memory(4096 * 4096);
+
+    Clock::time_point start = Clock::now();
+    std::size_t phase = 0;
+
+    Lexer lexer(workload.path);
+    std::vector<Token> tokens = lexer.lex();
+    workload.times[phase++].push_back(since(start));
+
+    Parser parser(std::move(tokens));
+    Program::ptr ast = parser.parse();
+    workload.times[phase++].push_back(since(start));
+
+    SymbolResolver symbol_resolver;
+    ast->accept(symbol_resolver);
+    workload.times[phase++].push_back(since(start));
+
+    TypeChecker type_checker(pool);
+    ast->accept(type_checker);
+    workload.times[phase++].push_back(since(start));
+
+    std::vector<CodeGenerator::entry_type> data
+            = CodeGenerator(pool).generate(*ast);
+    workload.times[phase++].push_back(since(start));
+
+    Assembler(data, memory).assemble();
+    workload.times[phase++].push_back(since(start));
+
+    std::string printed;
+    Output output(printed);
+    VirtualMachine vm(memory, output);
+    while (!vm.terminated()) {
+        vm.execute_step();
+    }
+    workload.times[phase++].push_back(since(start));
+
+    workload.steps = vm.steps();
+}
+
+static double percentile(std::vector<double> times, double p) {
+    std::sort(times.begin(), times.end());
+
+    /* Nearest rank */
+    std::size_t rank = static_cast<std::size_t>(std::ceil(p * times.size()));
+    return times[std::max<std::size_t>(rank, 1) - 1];
+}
+
+static void write_json(std::ostream &stream, std::string const &label,
+                       int runs, std::vector<Workload> const &workloads) {
+    JSONWriter writer(stream);
+
+    writer.begin_object();
+    writer.field("label", label);
+    writer.field("runs", runs);
+    writer.key("workloads");
+    writer.begin_list();
+
+    for (Workload const &workload : workloads) {
+        writer.begin_object();
+        writer.field("name", workload.name);
+        writer.field("steps", workload.steps);
+        writer.key("phases");
+        writer.begin_object();
+
+        for (std::size_t i = 0; i < PhaseCount; i++) {
+            writer.key(Phases[i]);
+            writer.begin_object();
+            writer.field("median_ms", percentile(workload.times[i], 0.5));
+            writer.field("p95_ms", percentile(workload.times[i], 0.95));
+            writer.end_object();
+        }
+
+        writer.end_object();
+        writer.end_object();
+    }
+
+    writer.end_list();
+    writer.end_object();
+    stream << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    int runs = 10;
+    std::string json;
+    std::string label;
+    std::vector<Workload> workloads;
+
+    /* Without the defaults of the pix command line */
+    options.json.spacing = 2;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--runs" && i + 1 < argc) {
+            runs = std::stoi(argv[++i]);
+        } else if (arg == "--json" && i + 1 < argc) {
+            json = argv[++i];
+        } else if (arg == "--label" && i + 1 < argc) {
+            label = argv[++i];
+        } else {
+            workloads.push_back({ arg, arg, {}, 0 });
+        }
+    }
+
+    if (runs <= 0) {
+        std::cerr << "--runs must be positive" << std::endl;
+        return 1;
+    }
+
+    /* A directory of its own, so that concurrent runs do not overwrite
+       each other's workloads */
+    std::string dir = std::string(P_tmpdir) + "/pix-bench-XXXXXX";
+    if (!mkdtemp(dir.data())) {
+        std::cerr << "Cannot create " << dir << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> generated = {
+        write_functions(dir, 2000), write_loop(dir, 1000000)
+    };
+    workloads.push_back({ "generated-functions", generated[0], {}, 0 });
+    workloads.push_back({ "generated-loop", generated[1], {}, 0 });
+
+    int status = 0;
+    try {
+        ThreadPool pool;
+
+        for (Workload &workload : workloads) {
+            for (int k = 0; k < runs; k++) {
+                run(workload, pool);
+            }
+        }
+    } catch (std::exception const &e) {
+        std::cerr << e.what() << std::endl;
+        status = 1;
+    }
+
+    for (std::string const &path : generated) {
+        std::remove(path.c_str());
+    }
+    rmdir(dir.c_str());
+
+    if (status != 0) {
+        return status;
+    }
+
+    std::cout << std::left << std::setw(24) << "workload";
+    for (char const *phase : Phases) {
+        std::cout << std::right << std::setw(16) << phase;
+    }
+    std::cout << std::endl << std::setw(24) << "" << std::right;
+    for (std::size_t i = 0; i < PhaseCount; i++) {
+        std::cout << std::setw(16) << "median/p95 ms";
+    }
+    std::cout << std::endl;
+
+    std::cout << std::fixed << std::setprecision(2);
+    for (Workload const &workload : workloads) {
+        std::cout << std::left << std::setw(24) << workload.name
+                  << std::right;
+
+        for (std::size_t i = 0; i < PhaseCount; i++) {
+            std::stringstream cell;
+            cell << std::fixed << std::setprecision(2)
+                 << percentile(workload.times[i], 0.5) << "/"
+                 << percentile(workload.times[i], 0.95);
+            std::cout << std::setw(16) << cell.str();
+        }
+        std::cout << std::endl;
+    }
+
+    if (!json.empty()) {
+        std::ofstream file(json);
+        if (!file) {
+            std::cerr << "Cannot write " << json << std::endl;
+            return 1;
+        }
+        write_json(file, label, runs, workloads);
+    }
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "incremental-compiler.hpp"
+#include "memory.hpp"
+#include "assembler.hpp"
+#include "thread-pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+/* Edits one function at a time in a file of many functions, and compares
+   recompiling it incrementally with compiling it from scratch.
+
+   usage: incremental [functions] [edits] [path]
+
+   Without a path, the source goes to a temporary directory of its own. */
+
+using Clock = std::chrono::steady_clock;
+
+static void write_source(std::string const &path,
+                         std::vector<int> const &values) {
+    int functions = values.size();
+    std::stringstream ss;
+
+    for (int i = 0; i < functions; i++) {
+        ss << "function f" << i << "(n: int) -> int {\n"
+           << "    x: int = n + " << values[i] << ";\n"
+           << "    if x > 1000 {\n"
+           << "        return x - 1000;\n"
+           << "    }\n";
+
+        if (i + 1 < functions) {
+            ss << "    return f" << i + 1 << "(x);\n";
+        } else {
+            ss << "    return x;\n";
+        }
+        ss << "}\n\n";
+    }
+    ss << "print(f0(0));\n";
+
+    std::ofstream(path) << ss.str();
+}
+
+static double compile(IncrementalCompiler &compiler) {
+    Clock::time_point start = Clock::now();
+
+    std::vector<CodeGenerator::entry_type> data = compiler.compile();
+    Memory memory(4096 * 4096);
+    Assembler(data, memory).assemble();
+
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count();
+}
+
+static double median(std::vector<double> times) {
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main(int argc, char *argv[]) {
+    int functions = argc > 1 ? std::stoi(argv[1]) : 10000;
+    int edits = argc > 2 ? std::stoi(argv[2]) : 20;
+    std::string dir;
+    std::string path;
+    if (argc > 3) {
+        path = argv[3];
+    } else {
+        dir = std::string(P_tmpdir) + "/pix-incremental-XXXXXX";
+        if (!mkdtemp(dir.data())) {
+            std::cerr << "Cannot create " << dir << std::endl;
+            return 1;
+        }
+        path = dir + "/incremental.pix";
+    }
+
+    int status = 0;
+    try {
+        ThreadPool pool;
+
+        std::vector<int> values(functions);
+        write_source(path, values);
+        IncrementalCompiler compiler(path, pool);
+        double initial = compile(compiler);
+
+        std::vector<double> incremental;
+        std::vector<double> scratch;
+        for (int k = 0; k < edits; k++) {
+            values[(k * 7919) % functions] += 1;
+            write_source(path, values);
+
+            incremental.push_back(compile(compiler));
+            if (compiler.full() || compiler.changed().size() != 1) {
+                std::cerr << "edit " << k << " was not compiled "
+                          << "incrementally" << std::endl;
+                status = 1;
+                break;
+            }
+
+            IncrementalCompiler fresh(path, pool);
+            scratch.push_back(compile(fresh));
+        }
+
+        if (status == 0) {
+            std::cout << "functions:            " << functions << std::endl
+                      << "edits:                " << edits << std::endl
+                      << "initial compile:      " << initial << " ms"
+                      << std::endl
+                      << "from scratch, median: " << median(scratch) << " ms"
+                      << std::endl
+                      << "incremental, median:  " << median(incremental)
+                      << " ms" << std::endl;
+        }
+    } catch (std::exception const &e) {
+        std::cerr << e.what() << std::endl;
+        status = 1;
+    }
+
+    if (!dir.empty()) {
+        std::remove(path.c_str());
+        rmdir(dir.c_str());
+    }
+
+    return status;
+}
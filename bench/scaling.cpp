@@ -0,0 +1,214 @@
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "symbol-resolver.hpp"
+#include "type-checker.hpp"
+#include "code-generator.hpp"
+#include "memory.hpp"
+#include "assembler.hpp"
+#include "thread-pool.hpp"
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* Compiles programs of growing size written by tools/generate, and prints
+   the time and peak memory of every phase as CSV, one line per size. Each
+   size is compiled in a child process, so that the peak of one does not
+   hide that of the next.
+
+   usage: scaling [--generator path] [--sizes n,n,...] [generator options] */
+
+using Clock = std::chrono::steady_clock;
+
+static char const *const Phases[] = {
+    "lex", "parse", "resolve", "typecheck", "codegen", "assemble"
+};
+
+static constexpr std::size_t PhaseCount = sizeof(Phases) / sizeof(Phases[0]);
+
+struct Sample {
+    double ms[PhaseCount];
+
+    /* High-water mark of the resident set after each phase */
+    long peak_kib[PhaseCount];
+
+    std::size_t tokens;
+    std::size_t instructions;
+};
+
+static long peak_kib() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void record(Sample &sample, std::size_t &phase,
+                   Clock::time_point &start) {
+    Clock::time_point now = Clock::now();
+
+    sample.ms[phase] = std::chrono::duration<double, std::milli>(now - start)
+            .count();
+    sample.peak_kib[phase] = peak_kib();
+    phase++;
+    start = now;
+}
+
+static Sample compile(std::string const &path) {
+    Sample sample{};
+    std::size_t phase = 0;
+    ThreadPool pool;
+
+    Clock::time_point start = Clock::now();
+
+    Lexer lexer(path);
+    std::vector<Token> tokens = lexer.lex();
+    sample.tokens = tokens.size();
+    record(sample, phase, start);
+
+    Parser parser(std::move(tokens));
+    Program::ptr ast = parser.parse();
+    record(sample, phase, start);
+
+    SymbolResolver symbol_resolver;
+    ast->accept(symbol_resolver);
+    record(sample, phase, start);
+
+    TypeChecker type_checker(pool);
+    ast->accept(type_checker);
+    record(sample, phase, start);
+
+    std::vector<CodeGenerator::entry_type> data
+            = CodeGenerator(pool).generate(*ast);
+    record(sample, phase, start);
+
+    Memory memory(4 * data.size() + (1 << 16));
+    Assembler assembler(data, memory);
+    assembler.assemble();
+    sample.instructions = assembler.end();
+    record(sample, phase, start);
+
+    return sample;
+}
+
+/* Runs compile() in a child, which sends back its sample through a pipe */
+static bool measure(std::string const &path, Sample &sample, long &total_kib) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    } else if (pid == 0) {
+        close(fds[0]);
+
+        int status = 0;
+        try {
+            Sample result = compile(path);
+            if (write(fds[1], &result, sizeof(result)) != sizeof(result)) {
+                status = 1;
+            }
+        } catch (std::exception const &e) {
+            std::cerr << e.what() << std::endl;
+            status = 1;
+        }
+        _exit(status);
+    }
+
+    close(fds[1]);
+    ssize_t length = read(fds[0], &sample, sizeof(sample));
+    close(fds[0]);
+
+    int status;
+    rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status)
+            || WEXITSTATUS(status) != 0 || length != sizeof(sample)) {
+        return false;
+    }
+
+    total_kib = usage.ru_maxrss;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    std::string generator = "tools/generate";
+    std::vector<int> sizes = { 250, 500, 1000, 2000, 4000, 8000, 16000 };
+    std::string options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--generator" && i + 1 < argc) {
+            generator = argv[++i];
+        } else if (arg == "--sizes" && i + 1 < argc) {
+            std::stringstream list(argv[++i]);
+            std::string size;
+
+            sizes.clear();
+            while (std::getline(list, size, ',')) {
+                sizes.push_back(std::stoi(size));
+            }
+        } else {
+            options += " " + arg;
+        }
+    }
+
+    /* A directory of its own, so that concurrent runs do not overwrite
+       each other's programs */
+    std::string dir = std::string(P_tmpdir) + "/pix-scaling-XXXXXX";
+    if (!mkdtemp(dir.data())) {
+        std::cerr << "Cannot create " << dir << std::endl;
+        return 1;
+    }
+
+    std::string path = dir + "/scaling.pix";
+    auto clean_up = [&]() {
+        std::remove(path.c_str());
+        rmdir(dir.c_str());
+    };
+
+    std::cout << "functions,bytes,tokens,instructions";
+    for (char const *phase : Phases) {
+        std::cout << "," << phase << "_ms," << phase << "_peak_kib";
+    }
+    std::cout << ",total_peak_kib" << std::endl;
+
+    for (int size : sizes) {
+        std::string command = generator + options + " --functions "
+                + std::to_string(size) + " -o " + path;
+        if (std::system(command.c_str()) != 0) {
+            std::cerr << "Failed: " << command << std::endl;
+            clean_up();
+            return 1;
+        }
+
+        Sample sample;
+        long total_kib;
+        if (!measure(path, sample, total_kib)) {
+            std::cerr << "Cannot compile " << size << " functions"
+                      << std::endl;
+            clean_up();
+            return 1;
+        }
+
+        std::ifstream source(path, std::ios::ate);
+
+        std::cout << size << "," << source.tellg() << "," << sample.tokens
+                  << "," << sample.instructions;
+        for (std::size_t i = 0; i < PhaseCount; i++) {
+            std::cout << "," << sample.ms[i] << "," << sample.peak_kib[i];
+        }
+        std::cout << "," << total_kib << std::endl;
+    }
+
+    clean_up();
+    return 0;
+}
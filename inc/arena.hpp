@@ -0,0 +1,83 @@
+#ifndef PIX_ARENA_HPP
+#define PIX_ARENA_HPP
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+
+/* Bump allocator owning a set of objects, which are laid out contiguously in
+   allocation order and destroyed all at once when the arena is. */
+class Arena {
+public:
+    static constexpr std::size_t DefaultBlockSize = 64 * 1024;
+
+    Arena(std::size_t block_size = DefaultBlockSize);
+
+    Arena(Arena &&other);
+
+    Arena &operator =(Arena &&other);
+
+    Arena(Arena const &) = delete;
+
+    Arena &operator =(Arena const &) = delete;
+
+    ~Arena();
+
+    template <typename T, typename... Args>
+    T *create(Args &&...args);
+
+    void clear();
+
+    std::size_t objects() const { return m_objects; }
+
+    std::size_t bytes() const { return m_bytes; }
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    struct Finalizer {
+        void *object;
+        void (*destroy)(void *object);
+    };
+
+    template <typename T>
+    static void destroy(void *object) { static_cast<T *>(object)->~T(); }
+
+    void *allocate(std::size_t size, std::size_t align);
+
+    void add_block(std::size_t min_size);
+
+    std::vector<Block> m_blocks;
+
+    std::vector<Finalizer> m_finalizers;
+
+    char *m_curr;
+
+    char *m_end;
+
+    std::size_t m_block_size;
+
+    std::size_t m_objects;
+
+    std::size_t m_bytes;
+};
+
+template <typename T, typename... Args>
+T *Arena::create(Args &&...args) {
+    void *mem = allocate(sizeof(T), alignof(T));
+    T *object = new (mem) T(std::forward<Args>(args)...);
+
+    if (!std::is_trivially_destructible<T>::value) {
+        m_finalizers.push_back({ object, &Arena::destroy<T> });
+    }
+    m_objects++;
+
+    return object;
+}
+
+#endif
@@ -19,7 +19,8 @@ public:
     Argument();
 
     Argument(void *option, std::string const &name, 
-             ArgType type, std::string const &init = "");
+             ArgType type, std::string const &init = "", 
+             bool required = false);
 
     void parse(ArgParser &args);
 
@@ -37,6 +38,8 @@ private:
     std::string m_init;
 
     std::string m_value;
+
+    bool m_required;
 };
 
 class ArgParser {
@@ -9,11 +9,19 @@
 
 class Assembler {
 public:
+    /* Code is placed from word origin on. Labels not defined by the data are
+       looked up in labels, e.g. those of code assembled earlier. */
     Assembler(std::vector<CodeGenerator::entry_type> const &data, 
-              Memory &memory);
+              Memory &memory, std::size_t origin = 0,
+              Label::map_type labels = {});
 
     void assemble();
 
+    Label::map_type const &labels() const { return m_labels; }
+
+    /* Word after the last instruction */
+    std::size_t end() const { return m_end; }
+
 private:
     void definition_pass();
 
@@ -24,6 +32,10 @@ private:
     Label::map_type m_labels;
 
     Memory &m_memory;
+
+    std::size_t m_origin;
+
+    std::size_t m_end;
 };
 
 #endif
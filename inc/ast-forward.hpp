@@ -19,6 +19,10 @@ class VariableDeclaration;
 
 class NamedTypeAnnotation;
 
+class PointerTypeAnnotation;
+
+class ArrayTypeAnnotation;
+
 class ScopedBlockStatement;
 
 class ExpressionStatement;
@@ -39,6 +43,8 @@ class UnaryExpression;
 
 class BinaryExpression;
 
+class IndexExpression;
+
 class Call;
 
 class Variable;
@@ -0,0 +1,211 @@
+#ifndef PIX_AST_SERIALIZER_HPP
+#define PIX_AST_SERIALIZER_HPP
+
+#include "ast.hpp"
+#include "visitor.hpp"
+#include "symbol-table.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cinttypes>
+
+/* Writes a resolved and type checked Program in a compact binary form, for
+   tools and for --ast-cache. The header is followed by tables of the
+   strings, the file names and the types, then by the nodes in pre-order:
+   each is its NodeKind, its type and its fields, with strings, types,
+   variables and functions referred to by index. Apart from the header, which
+   ends with a checksum of the rest, all integers are LEB128 varints. */
+class AstSerializer : public AstVisitor {
+public:
+    static constexpr char Magic[8] = "PIXAST";
+
+    static constexpr uint32_t Version = 2;
+
+    AstSerializer(Program &program);
+
+    /* Can only be called once. source identifies what the program was
+       compiled from, for caches to check */
+    void write(std::ostream &stream, uint64_t source = 0);
+
+    Node &visit(FunctionDeclaration &decl) override;
+
+    Node &visit(VariableDeclaration &decl) override;
+
+    Node &visit(NamedTypeAnnotation &anno) override;
+
+    Node &visit(PointerTypeAnnotation &anno) override;
+
+    Node &visit(ArrayTypeAnnotation &anno) override;
+
+    Node &visit(ScopedBlockStatement &stmt) override;
+
+    Node &visit(ExpressionStatement &stmt) override;
+
+    Node &visit(AssignStatement &stmt) override;
+
+    Node &visit(ReturnStatement &stmt) override;
+
+    Node &visit(IfElseStatement &stmt) override;
+
+    Node &visit(WhileStatement &stmt) override;
+
+    Node &visit(BreakStatement &stmt) override;
+
+    Node &visit(ContinueStatement &stmt) override;
+
+    Node &visit(UnaryExpression &expr) override;
+
+    Node &visit(BinaryExpression &expr) override;
+
+    Node &visit(IndexExpression &expr) override;
+
+    Node &visit(Call &expr) override;
+
+    Node &visit(Variable &expr) override;
+
+    Node &visit(Integer &expr) override;
+
+    Node &visit(BooleanLiteral &literal) override;
+
+private:
+    /* Writes the kind and the type, and counts the node's arena space */
+    template <typename T>
+    void begin(T &node);
+
+    /* Null nodes are written as NodeKind::None */
+    void write_node(Node *node);
+
+    template <typename T>
+    void write_list(std::vector<T *> const &nodes);
+
+    void write_token(Token const &token);
+
+    /* Declares the variable of the declaration being written */
+    void write_symbol(VariableSymbol &symbol);
+
+    uint32_t string(std::string const &str);
+
+    uint32_t file(std::string const &fname);
+
+    /* 0 for none */
+    uint32_t type(Type::unowned_ptr type);
+
+    Program &m_program;
+
+    std::ostringstream m_nodes;
+
+    std::ostringstream m_types;
+
+    std::unordered_map<std::string, uint32_t> m_string_ids;
+
+    std::vector<std::string> m_strings;
+
+    std::unordered_map<std::string, uint32_t> m_file_ids;
+
+    std::vector<std::string> m_files;
+
+    std::unordered_map<Type::unowned_ptr, uint32_t> m_type_ids;
+
+    std::unordered_map<VariableSymbol *, uint32_t> m_symbols;
+
+    /* The functions of the program, in pre-order, then the host functions
+       by ECallFunction */
+    std::unordered_map<FunctionDefinition *, uint32_t> m_definitions;
+
+    /* Upper bound of the arena space taken by the nodes */
+    std::size_t m_bytes;
+};
+
+/* Rebuilds a Program written by AstSerializer, with all of its nodes in a
+   single arena block sized by the writer. Variables and functions are
+   declared into the tables of their scopes as by the SymbolResolver, so the
+   program can be given straight to the CodeGenerator. */
+class AstDeserializer {
+public:
+    /* Reads the header and the tables, and throws unless the rest of the
+       stream matches the checksum */
+    AstDeserializer(std::istream &stream);
+
+    uint64_t source() const { return m_source; }
+
+    /* Can only be called once */
+    Program::ptr read();
+
+private:
+    /* Null for NodeKind::None */
+    Node::ptr read_node();
+
+    /* Throws unless the node is a T, or null where nullable */
+    template <typename T>
+    T *read_child(bool nullable = false);
+
+    template <typename T>
+    std::vector<T *> read_list();
+
+    FunctionDeclaration *read_function(Token const &func);
+
+    VariableDeclaration *read_variable(Token const &ident);
+
+    ScopedBlockStatement *read_block();
+
+    Token read_token();
+
+    /* Of a name to declare, which symbol tables key by its id */
+    Token read_identifier();
+
+    /* Of a literal that the later passes parse again */
+    Token read_integer();
+
+    std::string const &read_string();
+
+    Type::unowned_ptr read_type();
+
+    /* Of the type with the given index, which comes after it */
+    Type::unowned_ptr read_target(std::size_t type);
+
+    /* Of the declaration read last, whose type is that of annotation */
+    VariableSymbol::ptr read_symbol(TypeAnnotation::ptr annotation);
+
+    uint64_t read_index(std::size_t size, char const *what);
+
+    /* Throws unless each item can still take a byte */
+    uint64_t read_count(char const *what);
+
+    std::size_t remaining();
+
+    /* All that follows the header */
+    std::istringstream m_stream;
+
+    std::size_t m_size;
+
+    uint64_t m_source;
+
+    std::size_t m_bytes;
+
+    std::vector<std::string> m_strings;
+
+    std::vector<std::string> m_file_names;
+
+    /* The file names, in the arena so that tokens can refer to them */
+    std::vector<std::string const *> m_files;
+
+    std::vector<Type::unowned_ptr> m_types;
+
+    std::vector<VariableSymbol *> m_symbols;
+
+    std::vector<FunctionDefinition *> m_definitions;
+
+    std::size_t m_functions;
+
+    /* Calls with the definitions they refer to, which may come later */
+    std::vector<std::pair<Call *, uint64_t>> m_calls;
+
+    Program *m_program;
+
+    SymbolScope m_scope;
+};
+
+#endif
@@ -7,6 +7,7 @@
 #include "type.hpp"
 #include "symbol-table.hpp"
 #include "json.hpp"
+#include "arena.hpp"
 #include <vector>
 #include <memory>
 
@@ -17,6 +18,8 @@ enum class NodeKind {
     FunctionDeclaration,
     VariableDeclaration,
     NamedTypeAnnotation,
+    PointerTypeAnnotation,
+    ArrayTypeAnnotation,
     ScopedBlockStatement,
     ExpressionStatement,
     AssignStatement,
@@ -27,6 +30,7 @@ enum class NodeKind {
     ContinueStatement,
     UnaryExpression,
     BinaryExpression,
+    IndexExpression,
     Call,
     Variable,
     Integer,
@@ -45,13 +49,14 @@ public:
 
     virtual Node &accept(AstVisitor &visitor) = 0;
 
-    virtual JSON::ptr to_json() const = 0;
+    virtual void write_json(JSONWriter &writer) const = 0;
 
     virtual NodeKind kind() const = 0;
 
     virtual TextPosition const &pos() const = 0;
 
-    using ptr = std::unique_ptr<Node>;
+    /* Nodes are allocated in, and owned by, the Arena of their Program */
+    using ptr = Node *;
     using unowned_ptr = Node *;
 
     Type::unowned_ptr &type() { return m_type; }
@@ -59,7 +64,8 @@ public:
     void set_type(Type::unowned_ptr type) { m_type = type; }
 
     template <typename T>
-    static JSONList::ptr to_json_list(std::vector<T> const &list);
+    static void write_json_list(JSONWriter &writer,
+                                std::vector<T> const &list);
 
 protected:
     Type::unowned_ptr m_type;
@@ -69,44 +75,44 @@ class Statement : public Node {
 public:
     Statement();
 
-    JSON::ptr to_json() const override;
+    void write_json(JSONWriter &writer) const override;
 
-    using ptr = std::unique_ptr<Statement>;
+    using ptr = Statement *;
     using unowned_ptr = Statement *;
 
 private:
-    virtual void add_json_attributes(JSONObject &object) const = 0;
+    virtual void write_json_attributes(JSONWriter &writer) const = 0;
 };
 
 class Expression : public Node {
 public:
     Expression();
 
-    JSON::ptr to_json() const override;
+    void write_json(JSONWriter &writer) const override;
 
-    using ptr = std::unique_ptr<Expression>;
+    using ptr = Expression *;
     using unowned_ptr = Expression *;
 
 private:
-    virtual void add_json_attributes(JSONObject &object) const = 0;
+    virtual void write_json_attributes(JSONWriter &writer) const = 0;
 };
 
 class TypeAnnotation : public Node {
 public:
     TypeAnnotation();
 
-    JSON::ptr to_json() const override;
+    void write_json(JSONWriter &writer) const override;
 
-    using ptr = std::unique_ptr<TypeAnnotation>;
+    using ptr = TypeAnnotation *;
     using unowned_ptr = TypeAnnotation *;
 
 private:
-    virtual void add_json_attributes(JSONObject &object) const = 0;
+    virtual void write_json_attributes(JSONWriter &writer) const = 0;
 };
 
 class Program : public Node {
 public:
-    Program(std::vector<Statement::ptr> stmts);
+    Program(Arena arena, std::vector<Statement::ptr> stmts);
 
     Node &accept(AstVisitor &visitor) override { return visitor.visit(*this); }
 
@@ -114,18 +120,36 @@ public:
 
     TextPosition const &pos() const override { return m_stmts.front()->pos(); }
 
-    JSON::ptr to_json() const override;
+    void write_json(JSONWriter &writer) const override;
 
     std::vector<Statement::ptr> &stmts() { return m_stmts; }
 
     SymbolTable &symbols() { return m_symbols; }
 
+    /* All function declarations, including nested ones, in source order.
+       Filled in by the SymbolResolver */
+    std::vector<FunctionDeclaration *> &functions() { return m_functions; }
+
+    /* Variables declared outside of functions, in source order. Filled in
+       by the SymbolResolver */
+    std::vector<GlobalVariableSymbol *> &globals() { return m_globals; }
+
+    Arena const &arena() const { return m_arena; }
+
+    Arena &arena() { return m_arena; }
+
     using ptr = std::unique_ptr<Program>;
 
 private:
+    Arena m_arena;
+
     std::vector<Statement::ptr> m_stmts;
 
     SymbolTable m_symbols;
+
+    std::vector<FunctionDeclaration *> m_functions;
+
+    std::vector<GlobalVariableSymbol *> m_globals;
 };
 
 class ParameterDeclaration : public Statement {
@@ -142,10 +166,10 @@ public:
 
     TypeAnnotation::ptr &annotation() { return m_annotation; }
 
-    using ptr = std::unique_ptr<ParameterDeclaration>;
+    using ptr = ParameterDeclaration *;
 
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Token m_ident;
 
@@ -182,11 +206,11 @@ public:
     void set_definition(FunctionDefinition &definition) 
             { m_definition = &definition; }
 
-    using ptr = std::unique_ptr<FunctionDeclaration>;
+    using ptr = FunctionDeclaration *;
     using unowned_ptr = FunctionDeclaration *;
 
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Token m_func;
 
@@ -216,18 +240,25 @@ public:
 
     TypeAnnotation::ptr &annotation() { return m_annotation; }
 
+    /* Null for arrays, which start out zeroed */
     Expression::ptr &value() { return m_value; }
 
-    using ptr = std::unique_ptr<VariableDeclaration>;
+    VariableSymbol &symbol() { return *m_symbol; }
+
+    void set_symbol(VariableSymbol &symbol) { m_symbol = &symbol; }
+
+    using ptr = VariableDeclaration *;
 
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Token m_ident;
 
     TypeAnnotation::ptr m_annotation;
 
     Expression::ptr m_value;
+
+    VariableSymbol::unowned_ptr m_symbol;
 };
 
 class NamedTypeAnnotation : public TypeAnnotation {
@@ -243,11 +274,55 @@ public:
     Token const &ident() const { return m_ident; }
 
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Token m_ident;
 };
 
+class PointerTypeAnnotation : public TypeAnnotation {
+public:
+    PointerTypeAnnotation(Token const &star, TypeAnnotation::ptr target);
+
+    Node &accept(AstVisitor &visitor) override { return visitor.visit(*this); } 
+
+    NodeKind kind() const override { return NodeKind::PointerTypeAnnotation; }
+
+    TextPosition const &pos() const override { return m_star.pos(); }
+
+    Token const &star() const { return m_star; }
+
+    TypeAnnotation::ptr &target() { return m_target; }
+
+private:
+    void write_json_attributes(JSONWriter &writer) const;
+
+    Token m_star;
+
+    TypeAnnotation::ptr m_target;
+};
+
+class ArrayTypeAnnotation : public TypeAnnotation {
+public:
+    ArrayTypeAnnotation(TypeAnnotation::ptr target, Token const &length);
+
+    Node &accept(AstVisitor &visitor) override { return visitor.visit(*this); }
+
+    NodeKind kind() const override { return NodeKind::ArrayTypeAnnotation; }
+
+    TextPosition const &pos() const override { return m_target->pos(); }
+
+    TypeAnnotation::ptr &target() { return m_target; }
+
+    Token const &length() const { return m_length; }
+
+private:
+    void write_json_attributes(JSONWriter &writer) const;
+
+    TypeAnnotation::ptr m_target;
+
+    Token m_length;
+};
+
 class ScopedBlockStatement : public Statement {
 public:
     ScopedBlockStatement(std::vector<Statement::ptr> body);
@@ -263,7 +338,7 @@ public:
     SymbolTable &symbols() { return m_symbols; }
 
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     std::vector<Statement::ptr> m_body;
 
@@ -283,7 +358,7 @@ public:
     Expression::ptr &expr() { return m_expr; }
     
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Expression::ptr m_expr;
 };
@@ -303,7 +378,7 @@ public:
     Expression::ptr &value() { return m_value; }
 
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Expression::ptr m_target;
 
@@ -323,7 +398,7 @@ public:
     Expression::ptr &value() { return m_value; }
     
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Expression::ptr m_value;
 };
@@ -346,7 +421,7 @@ public:
     Statement::ptr &else_stmt() { return m_else_stmt; }
 
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Expression::ptr m_condition;
 
@@ -370,7 +445,7 @@ public:
     Statement::ptr &loop_stmt() { return m_loop_stmt; }
 
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Expression::ptr m_condition;
 
@@ -387,8 +462,10 @@ public:
 
     TextPosition const &pos() const override { return m_token.pos(); }
 
+    Token const &token() const { return m_token; }
+
 private:
-    void add_json_attributes(JSONObject &) const {}
+    void write_json_attributes(JSONWriter &) const {}
 
     Token m_token;
 };
@@ -403,8 +480,10 @@ public:
 
     TextPosition const &pos() const override { return m_token.pos(); }
 
+    Token const &token() const { return m_token; }
+
 private:
-    void add_json_attributes(JSONObject &) const {}
+    void write_json_attributes(JSONWriter &) const {}
 
     Token m_token;
 };
@@ -424,7 +503,7 @@ public:
     Expression::ptr &operand() { return m_operand; }
 
 private:    
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Token m_op;
 
@@ -449,7 +528,7 @@ public:
     Expression::ptr &right() { return m_right; }
 
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Token m_op;
 
@@ -458,6 +537,36 @@ private:
     Expression::ptr m_right;
 };
 
+/* Indexes the memory a pointer points to, in units of its target type */
+class IndexExpression : public Expression {
+public:
+    IndexExpression(Expression::ptr base, Expression::ptr index);
+
+    Node &accept(AstVisitor &visitor) override { return visitor.visit(*this); }
+
+    NodeKind kind() const override { return NodeKind::IndexExpression; }
+
+    TextPosition const &pos() const override { return m_base->pos(); }
+
+    Expression::ptr &base() { return m_base; }
+
+    Expression::ptr &index() { return m_index; }
+
+    /* Size of the target type in bytes, set by the TypeChecker */
+    int width() const { return m_width; }
+
+    void set_width(int width) { m_width = width; }
+
+private:
+    void write_json_attributes(JSONWriter &writer) const;
+
+    Expression::ptr m_base;
+
+    Expression::ptr m_index;
+
+    int m_width;
+};
+
 class Call : public Expression {
 public:
     Call(Token const &func, std::vector<Expression::ptr> args);
@@ -477,7 +586,7 @@ public:
     void set_called(FunctionDefinition &called) { m_called = &called; }
 
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Token m_func;
 
@@ -498,10 +607,16 @@ public:
 
     Token const &ident() const { return m_ident; }
 
+    VariableSymbol &symbol() { return *m_symbol; }
+
+    void set_symbol(VariableSymbol &symbol) { m_symbol = &symbol; }
+
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Token m_ident;
+
+    VariableSymbol::unowned_ptr m_symbol;
 };
 
 class Integer : public Expression {
@@ -517,7 +632,7 @@ public:
     Token const &literal() const { return m_literal; }
 
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Token m_literal;
 };
@@ -535,7 +650,7 @@ public:
     Token const &literal() const { return m_literal; }
 
 private:
-    void add_json_attributes(JSONObject &object) const;
+    void write_json_attributes(JSONWriter &writer) const;
 
     Token m_literal;
 
@@ -0,0 +1,45 @@
+#ifndef PIX_BATCH_RUNNER_HPP
+#define PIX_BATCH_RUNNER_HPP
+
+#include "memory.hpp"
+#include "output.hpp"
+#include "thread-pool.hpp"
+#include "opcode-histogram.hpp"
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cinttypes>
+
+/* Runs one assembled program for many inputs. Every instance starts from a
+   copy-on-write clone of the same memory and prints into a buffer of its
+   own, and instances are spread over the threads of the pool. */
+class BatchRunner {
+public:
+    struct Result {
+        std::string output;
+        std::string error;
+        uint64_t steps;
+    };
+
+    BatchRunner(Memory const &memory, ThreadPool &pool,
+                Output::Format format = Output::Format::Text);
+
+    /* The inputs of each instance are injected before it starts. The opcodes
+       executed by all instances are added to histogram, if given. */
+    std::vector<Result> run(std::vector<std::vector<uint32_t>> const &inputs,
+                            OpcodeHistogram *histogram = nullptr);
+
+    /* One instance per line, as integers separated by whitespace. Empty
+       lines and lines starting with # are skipped. */
+    static std::vector<std::vector<uint32_t>> read_inputs(
+            std::istream &stream);
+
+private:
+    MemoryImage m_image;
+
+    ThreadPool &m_pool;
+
+    Output::Format m_format;
+};
+
+#endif
@@ -5,22 +5,62 @@
 #include "instruction.hpp"
 #include "symbol.hpp"
 #include "symbol-table.hpp"
+#include "thread-pool.hpp"
 #include <vector>
-#include <queue>
 #include <stack>
 #include <unordered_map>
 #include <iostream>
+#include <string>
 #include <variant>
+#include <utility>
 
 class CodeGenerator : public AstVisitor {
 public:
-    CodeGenerator();
+    CodeGenerator(ThreadPool &pool);
 
     using entry_type = std::variant<Instruction, Label>;
 
-    std::vector<entry_type> generate(Program &ast);
+    /* Labels emitted before the code of statements, with their line, for
+       debuggers */
+    using line_map = std::vector<std::pair<Label, std::size_t>>;
 
-    void emit_function(FunctionDeclaration &decl);
+    /* Code of main or of a single function, with the functions it calls.
+       Blobs only refer to each other through labels scoped by the id of the
+       callee's definition, so each can be regenerated on its own. */
+    struct Blob {
+        std::vector<entry_type> data;
+        std::vector<FunctionDefinition *> callees;
+        line_map lines;
+    };
+
+    using blob_map = std::unordered_map<FunctionDefinition *, Blob>;
+
+    /* Also marks the statements in lines, if given */
+    std::vector<entry_type> generate(Program &ast, line_map *lines = nullptr);
+
+    Blob generate_main(Program &ast);
+
+    void generate_functions(std::vector<FunctionDeclaration *> const &functions,
+                            blob_map &blobs);
+
+    /* Concatenates main with the functions reachable from it, in the order
+       in which they are first called, followed by the data segment */
+    static std::vector<entry_type> link(
+            Blob const &main, blob_map const &blobs,
+            std::vector<GlobalVariableSymbol *> const &globals);
+
+    static Label entry_label(FunctionDefinition const &def);
+
+    /* Names of main and of every function, with their parameter types, by
+       the key of their entry label */
+    using name_map = std::unordered_map<uint64_t, std::string>;
+
+    static name_map function_names(Program &ast);
+
+    /* Start of the data segment, which is also the end of the code */
+    static Label data_label();
+
+    static Label global_label(GlobalVariableSymbol const &global);
 
     Node &default_action(Node &node) override;
 
@@ -50,6 +90,8 @@ public:
 
     Node &visit(BinaryExpression &expr) override;
 
+    Node &visit(IndexExpression &expr) override;
+
     Node &visit(Call &expr) override;
     
     Node &visit(Variable &expr) override;
@@ -68,11 +110,48 @@ public:
     void emit(Label label);
 
 private:
+    /* Generates the code of a single function, or of the top-level 
+       statements, into its own buffer */
+    CodeGenerator(int scope);
+
+    void emit_main(Program &ast);
+
+    void emit_function(FunctionDefinition &def);
+
+    /* Marks the start of statements other than blocks and functions if
+       lines are being collected */
+    void emit_statement(Statement &stmt);
+
+    /* Labels of globals are scoped apart from main and the functions */
+    static constexpr int GlobalScope = -1;
+
+    /* Jumps to target if expr evaluates to when, and falls through
+       otherwise. Logical operators only evaluate the operands they need
+       and jump straight to target rather than computing a bool. */
+    void emit_branch(Expression &expr, bool when, Label target);
+
+    /* Emits rel with the frame offset of a local, or abs with the address
+       of a global */
+    void emit_access(VariableSymbol &symbol, OpCode rel, OpCode abs);
+
+    /* The array of words indexed by expr, if it is a variable, which can be
+       indexed without computing its address first */
+    static VariableSymbol *word_array(IndexExpression &expr);
+
+    /* Indexed accesses of values of the given width in bytes */
+    static OpCode load_opcode(int width);
+
+    static OpCode store_opcode(int width);
+
+    ThreadPool *m_pool;
+
     std::vector<entry_type> m_data;
 
-    std::unordered_map<FunctionDefinition *, Label> m_func_labels;
+    std::vector<FunctionDefinition *> m_callees;
 
-    std::queue<FunctionDefinition *> m_jobs;
+    bool m_marks;
+
+    line_map m_lines;
 
     FunctionDefinition *m_curr_job;
 
@@ -80,9 +159,9 @@ private:
 
     std::stack<Label> m_continue_labels;
 
-    int m_fresh_id;
+    int m_scope;
 
-    SymbolScope m_scope;
+    int m_fresh_id;
 };
 
 std::ostream &operator <<(std::ostream &stream, 
@@ -0,0 +1,145 @@
+#ifndef PIX_DEBUGGER_HPP
+#define PIX_DEBUGGER_HPP
+
+#include "virtual-machine.hpp"
+#include "function-map.hpp"
+#include "code-generator.hpp"
+#include "ast.hpp"
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cinttypes>
+
+/* Interactive debugger for --debug, reading commands from stdin and
+   writing to stderr. A breakpoint is a Break instruction patched over the
+   first instruction of each statement on a line, or over the entry of a
+   function. Breaks stop the VM as exiting does, so the program runs at full
+   speed between stops. To go on from a breakpoint, the original
+   instruction is put back for a single step. */
+class Debugger {
+public:
+    /* lines are the statements marked by the CodeGenerator, source is the
+       file to show them from */
+    Debugger(VirtualMachine &vm, Program &program,
+             Label::map_type const &labels, FunctionMap const &functions,
+             CodeGenerator::line_map const &lines, std::string const &source);
+
+    /* Until the program exits or the user quits */
+    void run();
+
+private:
+    struct Breakpoint {
+        int id;
+        std::string location;
+
+        /* Byte addresses */
+        std::vector<std::size_t> addrs;
+    };
+
+    struct NamedVariable {
+        std::string name;
+        VariableSymbol *symbol;
+        std::size_t line;
+    };
+
+    struct Frame {
+        std::size_t ip;
+        std::size_t base;
+
+        /* Null for main */
+        FunctionDefinition *def;
+    };
+
+    /* Arrays are shown up to this many elements */
+    static constexpr std::size_t MaxElements = 32;
+
+    /* Returns false to quit */
+    bool execute(std::string const &line);
+
+    void help() const;
+
+    void add_breakpoint(std::string const &location);
+
+    void delete_breakpoint(int id);
+
+    void list_breakpoints() const;
+
+    /* Runs the program with run, then shows where it stopped */
+    template <typename F>
+    void go(F run);
+
+    /* Until a breakpoint or the end */
+    void resume();
+
+    /* Executes the instruction at the ip, even if a breakpoint is patched
+       over it */
+    void step_instruction();
+
+    /* Until the start of a statement, or with over of a statement in the
+       same frame or a caller */
+    void step_line(bool over);
+
+    /* From the innermost out */
+    std::vector<Frame> frames() const;
+
+    void backtrace() const;
+
+    void select_frame(std::size_t i);
+
+    void print_frame(std::size_t i, Frame const &frame) const;
+
+    void print(std::string const &name) const;
+
+    void print_locals() const;
+
+    void print_variable(NamedVariable const &var, Frame const &frame) const;
+
+    std::string format(Type::unowned_ptr type, std::size_t addr) const;
+
+    /* Of the statement of the instruction at ip, 0 if unknown */
+    std::size_t line(std::size_t ip) const;
+
+    std::vector<NamedVariable> const &variables(Frame const &frame) const;
+
+    static void collect(Statement &stmt, std::vector<NamedVariable> &vars);
+
+    VirtualMachine &m_vm;
+
+    Memory &m_memory;
+
+    Label::map_type const &m_labels;
+
+    FunctionMap const &m_functions;
+
+    uint32_t m_break;
+
+    /* Statement starts by address, and their addresses by line */
+    std::map<std::size_t, std::size_t> m_lines;
+
+    std::map<std::size_t, std::vector<std::size_t>> m_line_addrs;
+
+    std::vector<std::string> m_source;
+
+    /* By the word address of their entry */
+    std::unordered_map<uint32_t, FunctionDefinition *> m_definitions;
+
+    std::unordered_map<FunctionDefinition *, std::vector<NamedVariable>>
+            m_locals;
+
+    std::vector<NamedVariable> m_globals;
+
+    std::vector<Breakpoint> m_breakpoints;
+
+    int m_next_id;
+
+    /* Instructions that breakpoints are patched over, by address */
+    std::map<std::size_t, uint32_t> m_original;
+
+    std::size_t m_frame;
+
+    /* An error was thrown while running */
+    bool m_failed;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef PIX_FUNCTION_MAP_HPP
+#define PIX_FUNCTION_MAP_HPP
+
+#include "code-generator.hpp"
+#include "instruction.hpp"
+#include <string>
+#include <vector>
+#include <cinttypes>
+
+/* The functions of an assembled program by the addresses of their code, for
+   tools that observe the VM */
+class FunctionMap {
+public:
+    struct Function {
+        /* Word addresses of the first instruction and past the last */
+        uint32_t begin;
+        uint32_t end;
+
+        std::string name;
+    };
+
+    FunctionMap(Label::map_type const &labels,
+                CodeGenerator::name_map const &names);
+
+    /* The function of the instruction at the byte address, or nullptr */
+    Function const *find(std::size_t ip) const;
+
+    std::vector<Function> const &functions() const { return m_functions; }
+
+private:
+    /* In ascending order of address */
+    std::vector<Function> m_functions;
+};
+
+#endif
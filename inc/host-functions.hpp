@@ -0,0 +1,73 @@
+#ifndef PIX_HOST_FUNCTIONS_HPP
+#define PIX_HOST_FUNCTIONS_HPP
+
+#include "instruction.hpp"
+#include "type.hpp"
+#include <string>
+#include <vector>
+#include <cinttypes>
+
+class VirtualMachine;
+
+/* Native functions that pix code calls through ECall, numbered in the order
+   they were added. The builtins come first, in the order of ECallFunction.
+   Functions have to be added before compiling, and as snapshots and code
+   refer to them by number, in the same order on every run. */
+class HostFunctions {
+public:
+    /* Gets the arguments in the order of the parameters, and returns the
+       value pushed for the call, which is ignored for void functions */
+    using callback_type = uint32_t (*)(VirtualMachine &vm,
+                                       uint32_t const *args);
+
+    struct Function {
+        /* Functions without a name cannot be called from pix */
+        std::string name;
+        std::string mnemonic;
+        std::vector<Type::unowned_ptr> params;
+        Type::unowned_ptr ret;
+        callback_type callback;
+
+        /* Whether the call pushes the result, as all calls do, even to void
+           functions, unless they never return */
+        bool pushes_result;
+    };
+
+    static constexpr std::size_t MaxParams = 8;
+
+    static HostFunctions &registry();
+
+    /* The mnemonic shows up in disassembly and defaults to the name */
+    ECallFunction add(std::string name, std::vector<Type::unowned_ptr> params,
+                      Type::unowned_ptr ret, callback_type callback,
+                      std::string mnemonic = "", bool pushes_result = true);
+
+    Function const &get(ECallFunction ecall) const;
+
+    std::vector<Function> const &functions() const { return m_functions; }
+
+private:
+    HostFunctions();
+
+    static uint32_t none(VirtualMachine &vm, uint32_t const *args);
+
+    static uint32_t print_int(VirtualMachine &vm, uint32_t const *args);
+
+    static uint32_t print_bool(VirtualMachine &vm, uint32_t const *args);
+
+    static uint32_t input(VirtualMachine &vm, uint32_t const *args);
+
+    static uint32_t exit(VirtualMachine &vm, uint32_t const *args);
+
+    static uint32_t fill(VirtualMachine &vm, uint32_t const *args);
+
+    static uint32_t copy(VirtualMachine &vm, uint32_t const *args);
+
+    static uint32_t fill_rect(VirtualMachine &vm, uint32_t const *args);
+
+    static uint32_t blit(VirtualMachine &vm, uint32_t const *args);
+
+    std::vector<Function> m_functions;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef PIX_HOT_RELOADER_HPP
+#define PIX_HOT_RELOADER_HPP
+
+#include "incremental-compiler.hpp"
+#include "code-generator.hpp"
+#include "instruction.hpp"
+#include "memory.hpp"
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Applies edits of the source file to a running program, leaving its stack
+   and framebuffer alone. New versions of changed functions are assembled
+   after the code loaded so far, and every Call of an old version is patched
+   to the new one. Frames that are running an old version finish on it, as
+   the old code stays where it is, and so does the data segment. */
+class HotReloader {
+public:
+    HotReloader(IncrementalCompiler &compiler, Memory &memory);
+
+    ~HotReloader();
+
+    HotReloader(HotReloader const &) = delete;
+
+    HotReloader &operator =(HotReloader const &) = delete;
+
+    /* Assembles the first version at address 0 */
+    void load(std::vector<CodeGenerator::entry_type> const &data);
+
+    /* Reloads if the file was written since. Cheap enough to be called
+       between any two steps of the VM. */
+    void poll();
+
+    /* Errors are reported, and leave the running version as it is */
+    void reload();
+
+private:
+    static constexpr unsigned PollSteps = 256;
+
+    static constexpr std::chrono::milliseconds PollDelay{50};
+
+    bool written();
+
+    IncrementalCompiler &m_compiler;
+
+    Memory &m_memory;
+
+    int m_inotify;
+
+    std::string m_name;
+
+    /* Word address of the entry of every loaded function */
+    Label::map_type m_entries;
+
+    /* Word address of every global, which stay where they are */
+    Label::map_type m_globals;
+
+    /* Ranges of words holding code, old versions included */
+    std::vector<std::pair<std::size_t, std::size_t>> m_code;
+
+    std::size_t m_end;
+
+    unsigned m_polls;
+
+    std::chrono::steady_clock::time_point m_last_poll;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef PIX_INCREMENTAL_COMPILER_HPP
+#define PIX_INCREMENTAL_COMPILER_HPP
+
+#include "token.hpp"
+#include "ast.hpp"
+#include "code-generator.hpp"
+#include "thread-pool.hpp"
+#include <string>
+#include <vector>
+
+/* Compiles the same source file over and over, e.g. while it is being edited.
+   The tokens are split into top-level functions and everything else. When
+   only the bodies of some functions changed, or functions of new names were
+   added, just those are parsed, resolved, checked and generated again, and
+   the image is relinked from the cached code of all other functions. Any
+   other change is compiled from scratch. If a compilation fails, the
+   previous version is kept. */
+class IncrementalCompiler {
+public:
+    IncrementalCompiler(std::string fname, ThreadPool &pool);
+
+    /* Throws instead of compiling from scratch unless allow_full is set,
+       e.g. when the previous version is still running */
+    std::vector<CodeGenerator::entry_type> compile(bool allow_full = true);
+
+    std::string const &fname() const { return m_fname; }
+
+    Program &program() { return *m_program; }
+
+    CodeGenerator::blob_map const &blobs() const { return m_blobs; }
+
+    /* Whether the last compile() started from scratch */
+    bool full() const { return m_full; }
+
+    /* Definitions whose code was generated by the last compile() */
+    std::vector<FunctionDefinition *> const &changed() const
+            { return m_changed; }
+
+private:
+    /* Tokens of a top-level function, as indices into the token stream */
+    struct Span {
+        std::size_t begin;
+        std::size_t body;
+        std::size_t end;
+    };
+
+    struct Chunk {
+        std::string header;
+        std::string body;
+        FunctionDeclaration *decl;
+
+        /* decl and the functions nested in it, in source order */
+        std::vector<FunctionDeclaration *> functions;
+
+        /* The nodes of decl when it was compiled on its own, which are freed
+           when it is replaced. Empty for those in the program's arena. */
+        Arena arena;
+    };
+
+    static constexpr std::size_t NoChunk = -1;
+
+    struct Layout {
+        std::string main;
+        std::vector<Span> spans;
+        bool nested_main_functions;
+    };
+
+    static Layout split(std::vector<Token> const &tokens);
+
+    /* Kinds and lexemes of the tokens, but not their positions */
+    static std::string fingerprint(std::vector<Token> const &tokens,
+                                   std::size_t begin, std::size_t end);
+
+    static void append(std::string &fingerprint, Token const &token);
+
+    static bool matches(std::string const &fingerprint,
+                        std::vector<Token> const &tokens,
+                        std::size_t begin, std::size_t end);
+
+    void compile_all(std::vector<Token> tokens, Layout const &layout);
+
+    /* origins holds the previous chunk of each span, or NoChunk for new
+       functions, and updated the spans to compile */
+    void compile_changed(std::vector<Token> const &tokens,
+                         Layout const &layout,
+                         std::vector<std::size_t> const &origins,
+                         std::vector<std::size_t> const &updated);
+
+    std::string m_fname;
+
+    ThreadPool &m_pool;
+
+    Program::ptr m_program;
+
+    std::string m_main_fingerprint;
+
+    std::vector<Chunk> m_chunks;
+
+    CodeGenerator::Blob m_main;
+
+    CodeGenerator::blob_map m_blobs;
+
+    std::vector<FunctionDefinition *> m_changed;
+
+    bool m_full;
+};
+
+#endif
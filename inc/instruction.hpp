@@ -21,6 +21,8 @@ enum class OpCode {
     Push,
     Pop,
     LoadRel,
+
+    /* Absolute addresses are word addresses, such as those of labels */
     LoadAbs,
     StoreRel,
     StoreAbs,
@@ -36,17 +38,55 @@ enum class OpCode {
     IGT,
     IGE,
     Equ,
-    Neq
+    Neq,
+
+    /* Pop an index and a byte address, and access the value of the given
+       width at address + index * width */
+    LoadByte,
+    LoadHalf,
+    LoadWord,
+    StoreByte,
+    StoreHalf,
+    StoreWord,
+
+    /* Access word index of the array at the given offset from the base of
+       the frame, or push the address of that array */
+    LoadIdxRel,
+    StoreIdxRel,
+    AddrRel,
+
+    /* The same for arrays at the given word address */
+    LoadIdxAbs,
+    StoreIdxAbs,
+    AddrAbs,
+
+    /* Bitwise operations, >> shifts in the sign bit. Shift amounts are
+       taken modulo 32. */
+    IAnd,
+    IOr,
+    IXor,
+    INot,
+    IShl,
+    IShr,
+
+    INeg,
+
+    /* Stops the VM before itself, for debuggers to patch over code */
+    Break
 };
 
 std::string const &to_string(OpCode instr);
 
+OpCode opcode_from_string(std::string const &str);
+
 std::ostream &operator <<(std::ostream &stream, OpCode instr);
 
-enum class ECallFunction {
+/* Numbers of the builtin host functions, more can be added at runtime */
+enum class ECallFunction : uint32_t {
     None,
     PrintInt,
     PrintBool,
+    Input,
     Exit
 };
 
@@ -54,19 +94,31 @@ std::string const &to_string(ECallFunction ecall);
 
 std::ostream &operator <<(std::ostream &stream, ECallFunction ecall);
 
+/* Labels are numbered per scope, so that code for separate functions can be
+   generated independently and concatenated before assembly */
 class Label {
 public:
     Label();
 
     Label(int id);
 
+    Label(int scope, int id);
+
     friend std::ostream &operator <<(std::ostream &stream, Label const &label);
 
-    using map_type = std::unordered_map<int, uint32_t>;
+    using map_type = std::unordered_map<uint64_t, uint32_t>;
+
+    int scope() const { return m_scope; }
 
     int id() const { return m_id; }
 
+    uint64_t key() const 
+            { return (static_cast<uint64_t>(m_scope) << 32) 
+                     | static_cast<uint32_t>(m_id); }
+
 private:
+    int m_scope;
+
     int m_id;
 };
 
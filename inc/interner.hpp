@@ -0,0 +1,29 @@
+#ifndef PIX_INTERNER_HPP
+#define PIX_INTERNER_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cinttypes>
+
+/* Maps identifiers to small dense ids, so that later phases can compare and
+   hash names without touching the string. Id 0 is the empty string. */
+class Interner {
+public:
+    using id_type = uint32_t;
+
+    static id_type intern(std::string const &str);
+
+    static std::string const &lookup(id_type id);
+
+private:
+    Interner();
+
+    static Interner &instance();
+
+    std::unordered_map<std::string, id_type> m_ids;
+
+    std::vector<std::string const *> m_strings;
+};
+
+#endif
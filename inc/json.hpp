@@ -2,82 +2,87 @@
 #define PIX_JSON_HPP
 
 #include <string>
-#include <unordered_map>
 #include <vector>
-#include <memory>
 #include <iostream>
+#include <type_traits>
+#include <cmath>
+#include <cinttypes>
 
-class JSON {
+/* Writes JSON straight to a stream as it is produced, indented by
+   options.json.spacing. Keys are not checked for duplicates. */
+class JSONWriter {
 public:
-    JSON();
+    JSONWriter(std::ostream &stream);
 
-    virtual ~JSON() = default;
+    void begin_object();
 
-    virtual void write(std::ostream &stream, std::size_t depth) const = 0;
+    void end_object();
 
-    friend std::ostream &operator <<(std::ostream &stream, JSON const &json);
+    void begin_list();
 
-    using ptr = std::unique_ptr<JSON>;
-};
-
-class JSONString : public JSON {
-public:
-    JSONString(std::string const &value);
-
-    using ptr = std::unique_ptr<JSONString>;
-
-    static JSONString::ptr Create(std::string const &value);
+    void end_list();
 
-    virtual void write(std::ostream &stream, std::size_t depth) const;
+    /* Of the next value, which has to be in an object */
+    void key(std::string const &key);
 
-private:
-    std::string m_value;
-};
+    void value(std::string const &value);
 
-class JSONInteger : public JSON {
-public:
-    JSONInteger(int value);
+    void value(char const *value);
 
-    using ptr = std::unique_ptr<JSONInteger>;
+    template <typename T>
+    void value(T value);
 
-    static JSONInteger::ptr Create(int value);
+    template <typename T>
+    void field(std::string const &key, T const &value) {
+        this->key(key);
+        this->value(value);
+    }
 
-    virtual void write(std::ostream &stream, std::size_t depth) const;
+    /* With the quotes, and with quotes, backslashes and control characters
+       escaped */
+    static void write_string(std::ostream &stream, std::string const &value);
 
 private:
-    int m_value;
-};
-
-class JSONObject : public JSON {
-public:
-    JSONObject();
-
-    using ptr = std::unique_ptr<JSONObject>;
-
-    static JSONObject::ptr Create();
-
-    JSONObject &add_key(std::string const &key, JSON::ptr value);
-
-    virtual void write(std::ostream &stream, std::size_t depth) const;
+    struct Level {
+        bool object;
+        bool empty;
+    };
 
-private:
-    std::vector<std::pair<std::string, JSON::ptr>> m_keys;
-};
+    /* Separates a value from the one before, unless it is a key's */
+    void begin_value();
 
-class JSONList : public JSON {
-public:
-    JSONList();
+    /* Puts a value or key of an object or list on a line of its own */
+    void separate();
 
-    using ptr = std::unique_ptr<JSONList>;
+    void end(bool object);
 
-    static JSONList::ptr Create();
+    void indent(std::size_t depth);
 
-    void add(JSON::ptr value);
+    std::ostream &m_stream;
 
-    virtual void write(std::ostream &stream, std::size_t depth) const;
+    std::vector<Level> m_levels;
 
-private:
-    std::vector<JSON::ptr> m_list;
+    /* A key was written, and its value comes next */
+    bool m_keyed;
 };
 
+template <typename T>
+void JSONWriter::value(T value) {
+    static_assert(std::is_arithmetic<T>::value, "not a JSON value");
+    begin_value();
+
+    if constexpr (std::is_same<T, bool>::value) {
+        m_stream << (value ? "true" : "false");
+    } else if constexpr (std::is_floating_point<T>::value) {
+        if (!std::isfinite(value)) {
+            m_stream << "null";
+        } else {
+            m_stream << value;
+        }
+    } else {
+        /* Promotes chars to print them as numbers */
+        m_stream << +value;
+    }
+}
+
 #endif
@@ -2,6 +2,13 @@
 #define PIX_MEMORY_HPP
 
 #include <memory>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <cinttypes>
+
+class MemoryImage;
 
 class Memory {
 public:
@@ -11,6 +18,14 @@ public:
 
     void set_word(uint32_t word, std::size_t addr);
 
+    uint32_t get_half(std::size_t addr);
+
+    void set_half(uint32_t half, std::size_t addr);
+
+    uint32_t get_byte(std::size_t addr);
+
+    void set_byte(uint32_t byte, std::size_t addr);
+
     uint32_t pop_word();
 
     void push_word(uint32_t word);
@@ -21,6 +36,32 @@ public:
 
     void set_top(std::size_t base);
 
+    /* Bulk writes of bytes. Ranges have to lie below the top of the stack,
+       and rectangles are rows of width bytes, stride bytes apart. */
+    void fill(std::size_t addr, uint8_t value, std::size_t size);
+
+    void copy(std::size_t dst, std::size_t src, std::size_t size);
+
+    void fill_rect(std::size_t addr, uint8_t value, std::size_t width,
+                   std::size_t height, std::size_t stride);
+
+    void blit(std::size_t dst, std::size_t src, std::size_t width,
+              std::size_t height, std::size_t stride);
+
+    /* Records writes from now on, by rows of row_size bytes, all of which
+       start out dirty. Nothing is recorded before, so that running without
+       a display costs a single branch per write. */
+    void track_dirty(std::size_t row_size);
+
+    /* Byte ranges of the rows written since the last call, with adjacent
+       rows merged */
+    std::vector<std::pair<std::size_t, std::size_t>> take_dirty();
+
+    /* Stores the top and the contents, with runs of zeros left out */
+    void save(std::ostream &stream) const;
+
+    void load(std::istream &stream);
+
     char const *raw() const { return m_mem.get(); }
 
     std::size_t size() const { return m_size; }
@@ -28,11 +69,75 @@ public:
     std::size_t top() const { return m_top; }
 
 private:
-    std::unique_ptr<char[]> m_mem;
+    /* Shorter runs of zeros are stored as they are */
+    static constexpr std::size_t MinZeroRun = 16;
+
+    /* Frees memory that is either allocated or mapped */
+    struct Release {
+        std::size_t size;
+        bool mapped;
+
+        void operator ()(char *mem) const;
+    };
+
+    Memory(char *mapped, std::size_t size);
+
+    /* Accesses have to be aligned to their size */
+    void check_access(char const *name, std::size_t addr,
+                      std::size_t size) const {
+        if (addr % size != 0 || addr > m_size - size) {
+            access_error(name, addr, size);
+        }
+    }
+
+    [[noreturn]] void access_error(char const *name, std::size_t addr,
+                                   std::size_t size) const;
+
+    void check_range(char const *name, std::size_t addr, std::size_t width,
+                     std::size_t height, std::size_t stride) const;
+
+    void mark_dirty(std::size_t begin, std::size_t end) {
+        if (m_row_size) {
+            mark_rows(begin, end);
+        }
+    }
+
+    void mark_rows(std::size_t begin, std::size_t end);
+
+    std::unique_ptr<char[], Release> m_mem;
 
     std::size_t m_size;
 
     std::size_t m_top;
+
+    /* 0 while writes are not recorded */
+    std::size_t m_row_size;
+
+    std::vector<bool> m_dirty_rows;
+
+    friend MemoryImage;
+};
+
+/* Read-only copy of a memory, from which any number of copy-on-write clones
+   can be made. Pages are only copied once a clone writes to them. */
+class MemoryImage {
+public:
+    MemoryImage(Memory const &memory);
+
+    ~MemoryImage();
+
+    MemoryImage(MemoryImage const &) = delete;
+
+    MemoryImage &operator =(MemoryImage const &) = delete;
+
+    Memory clone() const;
+
+    std::size_t size() const { return m_size; }
+
+private:
+    int m_fd;
+
+    std::size_t m_size;
 };
 
 #endif
@@ -0,0 +1,65 @@
+#ifndef PIX_OPCODE_HISTOGRAM_HPP
+#define PIX_OPCODE_HISTOGRAM_HPP
+
+#include "instruction.hpp"
+#include "json.hpp"
+#include <unordered_map>
+#include <vector>
+#include <iostream>
+#include <cinttypes>
+
+/* Executions of every opcode, and of every sequence of two and three
+   opcodes executed one after the other, over any number of runs. Given to
+   VirtualMachine::execute_step() as its observer, so that only the runs
+   that count pay for it. */
+class OpcodeHistogram {
+public:
+    OpcodeHistogram();
+
+    void on_step(std::size_t, std::size_t, uint32_t instruction) {
+        uint32_t op = static_cast<uint8_t>(
+                Instruction::unpack_opcode(instruction));
+
+        m_singles[op]++;
+        m_window = (m_window << 8 | op) & 0xFFFFFF;
+
+        if (m_length >= 2) {
+            m_pairs[m_window & 0xFFFF]++;
+            m_triples[m_window]++;
+        } else if (++m_length == 2) {
+            m_pairs[m_window & 0xFFFF]++;
+        }
+    }
+
+    /* So that sequences do not span two runs */
+    void end_run();
+
+    void merge(OpcodeHistogram const &other);
+
+    uint64_t runs() const { return m_runs; }
+
+    void write_json(JSONWriter &writer) const;
+
+    /* Adds the counts of a histogram written by write_json() */
+    void load(std::istream &stream);
+
+private:
+    static constexpr std::size_t Opcodes = 256;
+
+    uint64_t m_runs;
+
+    std::vector<uint64_t> m_singles;
+
+    /* Indexed by the two opcodes, the first in the high byte */
+    std::vector<uint64_t> m_pairs;
+
+    /* Keyed the same way, by three opcodes */
+    std::unordered_map<uint32_t, uint64_t> m_triples;
+
+    /* The last opcodes executed, the latest in the low byte */
+    uint32_t m_window;
+
+    int m_length;
+};
+
+#endif
@@ -6,6 +6,20 @@
 struct Options {
     std::string filename;
     bool no_exec;
+    bool hot_reload;
+    std::string batch;
+    bool binary_output;
+    int jobs;
+    bool stats;
+    bool stats_json;
+    std::string opcode_histogram;
+    std::string trace;
+    std::string sample_profile;
+    int sample_rate;
+    bool perf_map;
+    bool perf_jitdump;
+    std::string ast_cache;
+    bool debugger;
 
     struct {
         bool tokens;
@@ -28,6 +42,12 @@ struct Options {
     struct {
         int spacing;
     } json;
+
+    struct {
+        std::string path;
+        int every;
+        std::string resume;
+    } snapshot;
 };
 
 extern Options options;
@@ -0,0 +1,71 @@
+#ifndef PIX_OUTPUT_HPP
+#define PIX_OUTPUT_HPP
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <cinttypes>
+
+/* What print() writes to. Values are collected in a buffer, which is written
+   out when it is full, on flush(), when poll() finds it has been waiting for
+   a while, and on destruction. As text every value is a line of its own, in
+   binary every value is a native int32. */
+class Output {
+public:
+    enum class Format {
+        Text, Binary
+    };
+
+    /* Writes to a file descriptor, which is left open */
+    Output(int fd, Format format = Format::Text);
+
+    /* Appends to a string, which has to outlive the output */
+    Output(std::string &target, Format format = Format::Text);
+
+    ~Output();
+
+    Output(Output const &) = delete;
+
+    Output &operator =(Output const &) = delete;
+
+    /* Signed as text, raw in binary */
+    void print_int(uint32_t value);
+
+    void print_bool(bool value);
+
+    void flush();
+
+    /* Flushes if values have been waiting for long. Cheap enough to be
+       called between any two steps of the VM. */
+    void poll();
+
+private:
+    static constexpr std::size_t BufferSize = 1 << 16;
+
+    /* Longest value as text: ">> -2147483648\n" */
+    static constexpr std::size_t MaxValueSize = 16;
+
+    static constexpr unsigned PollSteps = 4096;
+
+    static constexpr std::chrono::milliseconds PollDelay{100};
+
+    void reserve(std::size_t size);
+
+    void write(char const *data, std::size_t size);
+
+    int m_fd;
+
+    std::string *m_target;
+
+    Format m_format;
+
+    std::unique_ptr<char[]> m_buffer;
+
+    std::size_t m_used;
+
+    unsigned m_polls;
+
+    std::chrono::steady_clock::time_point m_last_flush;
+};
+
+#endif
@@ -22,6 +22,10 @@ public:
     Parser(std::vector<Token> tokens);
 
     Program::ptr parse();
+
+    /* Parses a lone function declaration, whose nodes are handed over to
+       arena, to be freed with the function */
+    FunctionDeclaration::ptr parse_function(Arena &arena);
 private:
     void advance();
 
@@ -63,16 +67,34 @@ private:
 
     Expression::ptr parse_expression();
 
+    Expression::ptr parse_or();
+
+    Expression::ptr parse_and();
+
+    Expression::ptr parse_not();
+
     Expression::ptr parse_equality_1();
 
     Expression::ptr parse_equality_2();
 
+    Expression::ptr parse_bitwise_or();
+
+    Expression::ptr parse_bitwise_xor();
+
+    Expression::ptr parse_bitwise_and();
+
+    Expression::ptr parse_shift();
+
     Expression::ptr parse_sum();
 
     Expression::ptr parse_term();
 
+    Expression::ptr parse_unary();
+
     Expression::ptr parse_value();
 
+    Expression::ptr parse_primary();
+
     Expression::ptr parse_atom();
 
     std::vector<Expression::ptr> parse_call_args();
@@ -80,6 +102,8 @@ private:
     std::vector<Token> m_tokens;
 
     std::size_t m_curr_idx;
+
+    Arena m_arena;
 };
 
 #endif
@@ -0,0 +1,89 @@
+#ifndef PIX_PERF_MAP_HPP
+#define PIX_PERF_MAP_HPP
+
+#include "virtual-machine.hpp"
+#include "function-map.hpp"
+#include <exception>
+#include <string>
+#include <cinttypes>
+
+/* Lets Linux perf attribute time to pix functions. Every function gets a
+   small native trampoline that calls back into the VM, and the steps of a
+   function are executed through its trampoline, so that with call graphs
+   (perf record -g) they show up below it. The trampolines are named in
+   /tmp/perf-<pid>.map, and optionally described by a jitdump file for
+   perf inject --jit. Only x86-64 and AArch64 are supported. */
+class PerfMap {
+public:
+    PerfMap(VirtualMachine &vm, FunctionMap const &functions, bool map,
+            bool jitdump);
+
+    /* The perf map is left behind for perf report */
+    ~PerfMap();
+
+    PerfMap(PerfMap const &) = delete;
+
+    PerfMap &operator =(PerfMap const &) = delete;
+
+    void execute_step() {
+        std::size_t word = m_vm.ip() / 4;
+        if (word < m_begin || word >= m_end) {
+            enter(word);
+        }
+
+        m_trampoline(this, &PerfMap::step);
+
+        if (m_error) {
+            rethrow();
+        }
+    }
+
+private:
+    using Step = void (*)(PerfMap *perf);
+
+    /* Calls step(perf) from a frame of its own */
+    using Trampoline = void (*)(PerfMap *perf, Step step);
+
+    /* Every trampoline is padded to this size */
+    static constexpr std::size_t StubSize = 32;
+
+    /* Switches to the trampoline of the function of the word */
+    void enter(std::size_t word);
+
+    static void step(PerfMap *perf) noexcept;
+
+    void rethrow();
+
+    void write_map(std::string const &path) const;
+
+    void write_jitdump(std::string const &path);
+
+    std::string const &name(std::size_t i) const;
+
+    uint8_t *stub(std::size_t i) const { return m_code + i * StubSize; }
+
+    VirtualMachine &m_vm;
+
+    FunctionMap const &m_functions;
+
+    /* One trampoline per function, and one more for code outside of them */
+    uint8_t *m_code;
+
+    std::size_t m_code_size;
+
+    /* Range of words of the current function, and its trampoline */
+    std::size_t m_begin;
+
+    std::size_t m_end;
+
+    Trampoline m_trampoline;
+
+    /* Thrown by the VM, which must not unwind through a trampoline */
+    std::exception_ptr m_error;
+
+    int m_jitdump;
+
+    void *m_jitdump_marker;
+};
+
+#endif
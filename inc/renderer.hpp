@@ -3,6 +3,8 @@
 
 #include <SDL2/SDL.h>
 #include <memory>
+#include <utility>
+#include <vector>
 
 class Renderer {
 public:
@@ -14,7 +16,11 @@ public:
 
     int process_events();
 
-    void draw_frame(char const *data);
+    /* Only bytes in the ranges, which are whole rows, are converted and
+       uploaded again */
+    void draw_frame(char const *data,
+                    std::vector<std::pair<std::size_t, std::size_t>> const
+                            &ranges);
 
 private:
     SDL_Window *m_window;
@@ -0,0 +1,70 @@
+#ifndef PIX_SAMPLE_PROFILER_HPP
+#define PIX_SAMPLE_PROFILER_HPP
+
+#include "virtual-machine.hpp"
+#include "function-map.hpp"
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <cinttypes>
+
+/* Samples the call stack of a VM at a fixed rate of CPU time, driven by
+   SIGPROF. The handler only raises a flag, and the stack is walked at the
+   start of the next step, when the frames are consistent. Given to
+   VirtualMachine::execute_step() as its observer. Stacks are written in
+   the folded format of flame graph tools. */
+class SampleProfiler {
+public:
+    SampleProfiler(VirtualMachine &vm, FunctionMap const &functions);
+
+    /* Stops the timer */
+    ~SampleProfiler();
+
+    SampleProfiler(SampleProfiler const &) = delete;
+
+    SampleProfiler &operator =(SampleProfiler const &) = delete;
+
+    /* Only one profiler can run at a time */
+    void start(int hz);
+
+    void stop();
+
+    void on_step(std::size_t ip, std::size_t, uint32_t) {
+        if (s_pending) {
+            s_pending = 0;
+            sample(ip);
+        }
+    }
+
+    uint64_t samples() const { return m_samples; }
+
+    /* One line per stack, callers first, with its number of samples */
+    void write(std::ostream &stream) const;
+
+private:
+    /* Frames deeper than this are left out */
+    static constexpr std::size_t MaxDepth = 256;
+
+    void sample(std::size_t ip);
+
+    std::string const &function_at(std::size_t ip) const;
+
+    static void handle(int);
+
+    static volatile std::sig_atomic_t s_pending;
+
+    VirtualMachine &m_vm;
+
+    FunctionMap const &m_functions;
+
+    std::unordered_map<std::string, uint64_t> m_stacks;
+
+    uint64_t m_samples;
+
+    bool m_running;
+
+    struct sigaction m_previous;
+};
+
+#endif
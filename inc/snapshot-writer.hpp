@@ -0,0 +1,35 @@
+#ifndef PIX_SNAPSHOT_WRITER_HPP
+#define PIX_SNAPSHOT_WRITER_HPP
+
+#include "virtual-machine.hpp"
+#include <string>
+#include <sys/types.h>
+
+/* Writes snapshots of a VM from a forked child, so that the VM is paused
+   only for the fork itself; copy-on-write keeps the memory of the child as
+   it was at that point. Files are replaced atomically. */
+class SnapshotWriter {
+public:
+    SnapshotWriter(std::string path);
+
+    ~SnapshotWriter();
+
+    SnapshotWriter(SnapshotWriter const &) = delete;
+
+    SnapshotWriter &operator =(SnapshotWriter const &) = delete;
+
+    /* Skipped, returning false, while the previous one is still written */
+    bool write(VirtualMachine const &vm);
+
+    void wait();
+
+private:
+    /* Whether no child is left running */
+    bool reap(bool block);
+
+    std::string m_path;
+
+    pid_t m_child;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef PIX_STATS_HPP
+#define PIX_STATS_HPP
+
+#include "json.hpp"
+#include <chrono>
+#include <cinttypes>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* Wall time and allocations of the phases of a run, and counts of what they
+   produced, for --stats. Allocations are only counted in builds with
+   PIX_ALLOC_STATS defined (make STATS=1), which replace the global operator
+   new, so that other builds pay nothing for it. */
+class Stats {
+public:
+    struct Phase {
+        std::string name;
+        double seconds;
+        uint64_t allocations;
+        uint64_t bytes;
+    };
+
+    Stats();
+
+    /* Stops the running phase, if any */
+    void start(std::string const &name);
+
+    void stop();
+
+    void count(std::string const &name, uint64_t value);
+
+    std::vector<Phase> const &phases() const { return m_phases; }
+
+    void write(std::ostream &stream) const;
+
+    /* Leaves out the allocations if they are not counted */
+    void write_json(JSONWriter &writer) const;
+
+    static bool counts_allocations();
+
+    /* Since the start of the process, by all threads */
+    static uint64_t allocations();
+
+    static uint64_t allocated_bytes();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<Phase> m_phases;
+
+    std::vector<std::pair<std::string, uint64_t>> m_counts;
+
+    Clock::time_point m_created;
+
+    Clock::time_point m_started;
+
+    uint64_t m_allocations;
+
+    uint64_t m_bytes;
+
+    bool m_running;
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "visitor.hpp"
 #include "symbol-table.hpp"
+#include "host-functions.hpp"
 
 class SymbolResolver : public AstVisitor {
 public:
@@ -7,6 +8,13 @@ public:
 
     Node &visit(Program &program) override;
 
+    /* Resolves a top-level function that was parsed on its own, binding it
+       to def, the definition of its previous version, if given. Returns the
+       function and the functions nested in it, in source order. */
+    std::vector<FunctionDeclaration *> resolve_function(
+            Program &program, FunctionDeclaration &decl, 
+            FunctionDefinition *def);
+
     Node &visit(ParameterDeclaration &decl) override;
 
     Node &visit(FunctionDeclaration &decl) override;
@@ -15,21 +23,38 @@ public:
 
     Node &visit(NamedTypeAnnotation &anno) override;
 
+    Node &visit(PointerTypeAnnotation &anno) override;
+
+    Node &visit(ArrayTypeAnnotation &anno) override;
+
     Node &visit(ScopedBlockStatement &stmt) override;
 
     Node &visit(IfElseStatement &stmt) override;
 
     Node &visit(WhileStatement &stmt) override;
 
+    /* Declares the basic types and the host functions in the current table
+       of scope */
+    static void declare_builtins(SymbolScope &scope);
+
 private:
-    void declare_basic_type(std::string const &name, Type::unowned_ptr type);
+    static void declare_basic_type(SymbolScope &scope, std::string const &name,
+                                   Type::unowned_ptr type);
 
-    void declare_basic_function(std::string const &name, 
-                                Type::unowned_ptr param_type, 
-                                Type::unowned_ptr ret_type, 
-                                ECallFunction ecall);
+    static void declare_basic_function(SymbolScope &scope,
+                                       HostFunctions::Function const &function,
+                                       ECallFunction ecall);
 
     SymbolScope m_scope;
 
     std::vector<LocalVariableSymbol::unowned_ptr> m_declared;
+
+    std::vector<FunctionDeclaration *> *m_functions;
+
+    std::vector<GlobalVariableSymbol *> *m_globals;
+
+    FunctionDefinition *m_rebind;
+
+    /* Number of functions being resolved, nested ones included */
+    int m_depth;
 };
@@ -3,28 +3,57 @@
 
 #include "symbol.hpp"
 #include "token.hpp"
-#include <unordered_map>
+#include "interner.hpp"
+#include <vector>
 #include <string>
 
 class SymbolScope;
 
+/* Open-addressing table keyed by interned identifier ids. Empty tables, such
+   as those of most blocks, do not allocate. */
 class SymbolTable {
 public:
     SymbolTable();
 
-    void insert(std::string const &ident, Symbol::ptr symbol);
+    void insert(Interner::id_type ident, Symbol::ptr symbol);
 
-    Symbol::unowned_ptr lookup(Token const &ident) const;
+    /* Returns nullptr if ident is not defined */
+    Symbol::ptr remove(Interner::id_type ident);
+
+    Symbol::unowned_ptr lookup(Interner::id_type ident) const;
+
+    Symbol::unowned_ptr lookup(Token const &ident) const 
+            { return lookup(ident.id()); }
 
-    bool defines(std::string const &ident) const;
+    bool defines(Interner::id_type ident) const 
+            { return lookup(ident) != nullptr; }
 
     friend std::ostream &operator <<(std::ostream &stream, 
                                      SymbolTable const &table);
 
     using unowned_ptr = SymbolTable *;
 
+    SymbolTable::unowned_ptr parent() const { return m_parent; }
+
+    void set_parent(SymbolTable::unowned_ptr parent) { m_parent = parent; }
+
 private:
-    std::unordered_map<std::string, Symbol::ptr> m_map;
+    struct Entry {
+        Interner::id_type ident;
+        Symbol::ptr symbol;
+    };
+
+    std::size_t home(Interner::id_type ident) const;
+
+    std::size_t slot(Interner::id_type ident) const;
+
+    void grow();
+
+    std::vector<Entry> m_entries;
+
+    std::size_t m_size;
+
+    SymbolTable::unowned_ptr m_parent;
 
     friend SymbolScope;
 };
@@ -35,6 +64,9 @@ public:
 
     void enter(SymbolTable &symbols);
 
+    /* Enters symbols and all its parents, outermost first */
+    void enter_nested(SymbolTable &symbols);
+
     void leave(SymbolTable &symbols);
 
     Symbol::unowned_ptr lookup(Token const &ident) const;
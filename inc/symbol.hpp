@@ -8,6 +8,7 @@
 #include <vector>
 #include <variant>
 #include <memory>
+#include <algorithm>
 
 class Symbol {
 public:
@@ -64,15 +65,29 @@ private:
 
 class VariableSymbol : public Symbol {
 public:
-    VariableSymbol(Type::unowned_ptr type);
+    VariableSymbol(Type::unowned_ptr type, bool is_global);
 
     using ptr = std::unique_ptr<VariableSymbol>;
     using unowned_ptr = VariableSymbol *;
 
     Type::unowned_ptr type() const { return m_type; }
 
+    /* Decided once here, as code is generated by it for every use */
+    bool is_array() const { return m_is_array; }
+
+    /* A GlobalVariableSymbol, else a LocalVariableSymbol */
+    bool is_global() const { return m_is_global; }
+
+    /* Number of words the variable takes in its frame or the data segment */
+    std::size_t words() const
+            { return std::max<std::size_t>(1, (m_type->size() + 3) / 4); }
+
 protected:
     Type::unowned_ptr m_type;
+
+    bool m_is_array;
+
+    bool m_is_global;
 };
 
 class LocalVariableSymbol : public VariableSymbol {
@@ -92,6 +107,25 @@ private:
     int m_offset;
 };
 
+/* Variables declared outside of functions, which live in the data segment
+   after the code. Their address is that of a label, as it is only known
+   once the code is laid out. */
+class GlobalVariableSymbol : public VariableSymbol {
+public:
+    GlobalVariableSymbol(Type::unowned_ptr type, int id);
+
+    void write(std::ostream &stream) const override;
+
+    using ptr = std::unique_ptr<GlobalVariableSymbol>;
+    using unowned_ptr = GlobalVariableSymbol *;
+
+    /* Ids start at 1, in order of declaration */
+    int id() const { return m_id; }
+
+private:
+    int m_id;
+};
+
 class FunctionDefinition;
 
 class FunctionSymbol : public Symbol {
@@ -120,6 +154,15 @@ public:
                        std::vector<LocalVariableSymbol::unowned_ptr> params,
                        std::vector<LocalVariableSymbol::unowned_ptr> locals);
 
+    /* Rebinds the definition to a re-parsed declaration of the same 
+       signature, keeping its identity for callers */
+    void rebind(FunctionDeclaration *decl,
+                std::vector<LocalVariableSymbol::unowned_ptr> params,
+                std::vector<LocalVariableSymbol::unowned_ptr> locals);
+
+    /* Unique for the lifetime of the process */
+    int id() const { return m_id; }
+
     bool is_ecall() const 
             { return std::holds_alternative<ECallFunction>(m_def); }
 
@@ -139,6 +182,9 @@ public:
     std::vector<LocalVariableSymbol::unowned_ptr> const &locals() 
             { return m_locals; }
 
+    /* Number of words taken by the locals */
+    std::size_t frame_size() const;
+
     friend std::ostream &operator <<(std::ostream &stream, 
                                      FunctionDefinition const &def);
 
@@ -147,6 +193,10 @@ public:
     using unowned_ptr = FunctionDefinition *;
 
 private:
+    static int next_id();
+
+    int m_id;
+
     FunctionType::ptr m_type;
 
     std::variant<ECallFunction, FunctionDeclaration *> m_def;
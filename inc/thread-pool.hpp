@@ -0,0 +1,66 @@
+#ifndef PIX_THREAD_POOL_HPP
+#define PIX_THREAD_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+/* Fixed set of workers, each with its own task deque. Workers take tasks from
+   the back of their own deque and steal from the front of the others. The
+   thread calling parallel_for() works as one of them until its tasks are
+   done, so n threads take n - 1 workers, and tasks can call parallel_for()
+   themselves. */
+class ThreadPool {
+public:
+    ThreadPool(std::size_t threads = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const &) = delete;
+
+    ThreadPool &operator =(ThreadPool const &) = delete;
+
+    /* Calls fn(0) ... fn(n - 1) and waits for all of them, running tasks
+       meanwhile. If any call throws, the exception of the lowest index is
+       rethrown. */
+    void parallel_for(std::size_t n, std::function<void(std::size_t)> const &fn);
+
+    std::size_t size() const { return m_threads.size(); }
+
+private:
+    using Task = std::function<void()>;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(std::size_t self);
+
+    bool take(std::size_t self, Task &task);
+
+    /* The deque of the calling thread, that of the first worker for
+       threads outside of the pool */
+    std::size_t self() const;
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_wake;
+
+    std::condition_variable m_done;
+
+    std::atomic<std::size_t> m_queued;
+
+    bool m_stop;
+};
+
+#endif
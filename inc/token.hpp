@@ -2,6 +2,7 @@
 #define PIX_TOKEN_HPP
 
 #include "text-position.hpp"
+#include "interner.hpp"
 #include <string>
 #include <iostream>
 
@@ -21,6 +22,9 @@ enum class TokenKind {
     True,
     False,
     Null,
+    And,
+    Or,
+    Not,
 
     Arrow,
     Equals,
@@ -35,6 +39,12 @@ enum class TokenKind {
     Times,
     FloorDiv,
     Modulo,
+    Ampersand,
+    Pipe,
+    Caret,
+    Tilde,
+    ShiftLeft,
+    ShiftRight,
 
     ParenLeft,
     ParenRight,
@@ -75,10 +85,14 @@ public:
 
     std::string const &lexeme() const 
             { return m_lexeme.empty() ? to_string(m_kind) : m_lexeme; }
+
+    Interner::id_type id() const { return m_id; }
 private:
     TextPosition m_pos;
 
     TokenKind m_kind;
+
+    Interner::id_type m_id;
     
     std::string const m_lexeme;
 };
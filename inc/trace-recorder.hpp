@@ -0,0 +1,83 @@
+#ifndef PIX_TRACE_RECORDER_HPP
+#define PIX_TRACE_RECORDER_HPP
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cinttypes>
+
+/* Records the instruction pointer, the top of the stack and the instruction
+   of every step into a ring buffer, from which a background thread writes
+   them to a file. Given to VirtualMachine::execute_step() as its observer.
+   The ring has a single producer and a single consumer, so neither takes a
+   lock; the VM only waits when the file cannot keep up. */
+class TraceRecorder {
+public:
+    struct Record {
+        uint32_t ip;
+        uint32_t top;
+        uint32_t instruction;
+    };
+
+    /* Files start with the magic and the version, then hold Records in
+       native byte order */
+    static constexpr char Magic[8] = "PIXTRCE";
+
+    static constexpr uint32_t Version = 1;
+
+    TraceRecorder(std::string const &path);
+
+    /* Writes what is left in the ring */
+    ~TraceRecorder();
+
+    TraceRecorder(TraceRecorder const &) = delete;
+
+    TraceRecorder &operator =(TraceRecorder const &) = delete;
+
+    void on_step(std::size_t ip, std::size_t top, uint32_t instruction) {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+
+        if (head - m_tail_cache == Capacity) {
+            wait_for_space(head);
+        }
+
+        m_ring[head & (Capacity - 1)] = {
+            static_cast<uint32_t>(ip), static_cast<uint32_t>(top),
+            instruction
+        };
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    /* Times the VM found the ring full */
+    uint64_t stalls() const { return m_stalls; }
+
+private:
+    static constexpr std::size_t Capacity = 1 << 16;
+
+    void wait_for_space(std::size_t head);
+
+    void drain();
+
+    std::ofstream m_file;
+
+    std::vector<Record> m_ring;
+
+    /* Records written by the VM, and taken by the drainer */
+    alignas(64) std::atomic<std::size_t> m_head;
+
+    alignas(64) std::atomic<std::size_t> m_tail;
+
+    /* The VM's last view of m_tail, so that it reads it only when the ring
+       looks full */
+    alignas(64) std::size_t m_tail_cache;
+
+    uint64_t m_stalls;
+
+    std::atomic<bool> m_done;
+
+    std::thread m_drainer;
+};
+
+#endif
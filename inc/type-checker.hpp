@@ -4,15 +4,20 @@
 #include "visitor.hpp"
 #include "ast.hpp"
 #include "symbol-table.hpp"
+#include "thread-pool.hpp"
 
 class TypeChecker : public AstVisitor {
 public:
-    TypeChecker() = default;
+    TypeChecker(ThreadPool &pool);
 
     Node &default_action(Node &node) override;
 
     Node &visit(Program &program) override;
 
+    /* Checks the bodies of the given functions only, e.g. after they were
+       parsed again on their own */
+    void check_functions(std::vector<FunctionDeclaration *> const &functions);
+
     Node &visit(ParameterDeclaration &decl) override;
 
     Node &visit(FunctionDeclaration &decl) override;
@@ -39,6 +44,8 @@ public:
 
     Node &visit(BinaryExpression &expr) override;
 
+    Node &visit(IndexExpression &expr) override;
+
     Node &visit(Call &expr) override;
     
     Node &visit(Variable &expr) override;
@@ -48,12 +55,22 @@ public:
     Node &visit(BooleanLiteral &expr) override;
 
 private:
+    void check_main(Program &program);
+
+    void check_function(FunctionDeclaration &decl);
+
+    /* The context is only built when the coercion fails */
+    template <typename Context>
     void coerce_types(Expression::ptr &target, Type::unowned_ptr expected, 
-                      TextPosition const &pos, std::string const &context);
+                      TextPosition const &pos, Context const &context);
+
+    ThreadPool &m_pool;
 
     SymbolScope m_scope;
 
     FunctionDeclaration::unowned_ptr m_curr_function;
+
+    std::vector<FunctionDefinition *> m_defs;
 };
 
 #endif
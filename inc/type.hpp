@@ -23,26 +23,87 @@ public:
 
     static Type::unowned_ptr VoidType();
 
-    virtual JSONObject::ptr to_json() const = 0;
+    /* Only stored behind pointers, and loaded as int */
+    static Type::unowned_ptr ByteType();
+
+    static Type::unowned_ptr HalfType();
+
+    virtual void write_json(JSONWriter &writer) const = 0;
 
     virtual void write(std::ostream &stream) const = 0;
 
+    /* Size of a value in memory, in bytes */
+    virtual std::size_t size() const { return 4; }
+
     friend std::ostream &operator <<(std::ostream &stream, Type const &type);
 };
 
 class NamedType : public Type {
 public:
-    NamedType(std::string const &name);
+    NamedType(std::string const &name, std::size_t size = 4);
 
-    JSONObject::ptr to_json() const;
+    void write_json(JSONWriter &writer) const;
 
     void write(std::ostream &stream) const override;
 
+    std::size_t size() const override { return m_size; }
+
     using ptr = std::unique_ptr<NamedType>;
     using unowned_ptr = NamedType *;
 
 private:
     std::string m_name;
+
+    std::size_t m_size;
+};
+
+/* Types are compared by identity, so there is one pointer type for every
+   target type */
+class PointerType : public Type {
+public:
+    static Type::unowned_ptr Get(Type::unowned_ptr target);
+
+    void write_json(JSONWriter &writer) const;
+
+    void write(std::ostream &stream) const override;
+
+    Type::unowned_ptr target() const { return m_target; }
+
+    using ptr = std::unique_ptr<PointerType>;
+    using unowned_ptr = PointerType *;
+
+private:
+    PointerType(Type::unowned_ptr target);
+
+    Type::unowned_ptr m_target;
+};
+
+/* Arrays of values laid out one after the other. Like pointer types, there
+   is one array type for every target type and length. */
+class ArrayType : public Type {
+public:
+    static Type::unowned_ptr Get(Type::unowned_ptr target, std::size_t length);
+
+    void write_json(JSONWriter &writer) const;
+
+    void write(std::ostream &stream) const override;
+
+    std::size_t size() const override
+            { return m_target->size() * m_length; }
+
+    Type::unowned_ptr target() const { return m_target; }
+
+    std::size_t length() const { return m_length; }
+
+    using ptr = std::unique_ptr<ArrayType>;
+    using unowned_ptr = ArrayType *;
+
+private:
+    ArrayType(Type::unowned_ptr target, std::size_t length);
+
+    Type::unowned_ptr m_target;
+
+    std::size_t m_length;
 };
 
 class FunctionType : public Type {
@@ -50,7 +111,7 @@ public:
     FunctionType(std::vector<Type::unowned_ptr> params, 
                  Type::unowned_ptr ret_type);
 
-    JSONObject::ptr to_json() const;
+    void write_json(JSONWriter &writer) const;
 
     void write(std::ostream &stream) const override;
 
@@ -1,7 +1,10 @@
 #ifndef PIX_UTILS_HPP
 #define PIX_UTILS_HPP
 
+#include "error.hpp"
 #include <unordered_map>
+#include <iostream>
+#include <type_traits>
 
 template <typename T, typename U>
 std::unordered_map<U, T> inverse(std::unordered_map<T, U> map) {
@@ -14,4 +17,23 @@ std::unordered_map<U, T> inverse(std::unordered_map<T, U> map) {
     return inverted;
 }
 
+/* Raw native-endian values, for files written and read on the same kind of
+   machine */
+template <typename T>
+void write_binary(std::ostream &stream, T value) {
+    static_assert(std::is_trivially_copyable<T>::value, "not a plain value");
+    stream.write(reinterpret_cast<char const *>(&value), sizeof(T));
+}
+
+template <typename T>
+T read_binary(std::istream &stream) {
+    static_assert(std::is_trivially_copyable<T>::value, "not a plain value");
+
+    T value;
+    if (!stream.read(reinterpret_cast<char *>(&value), sizeof(T))) {
+        throw FatalError("read_binary(): unexpected end of input");
+    }
+    return value;
+}
+
 #endif
@@ -3,31 +3,104 @@
 
 #include "memory.hpp"
 #include "instruction.hpp"
+#include "output.hpp"
+#include "host-functions.hpp"
+#include <iostream>
+#include <vector>
+#include <cinttypes>
 
 class VirtualMachine {
 public:
-    VirtualMachine(Memory &memory);
+    struct NoObserver {
+        void on_step(std::size_t, std::size_t, uint32_t) {}
+    };
+
+    VirtualMachine(Memory &memory, Output &output);
+
+    /* Stores values at the top of memory, below which the stack then
+       starts, for input(i) to read. Called before the first step. */
+    void inject(std::vector<uint32_t> const &values);
 
     void execute_quantum(int q);
 
-    void execute_step();
- 
+    void execute_step() { execute_step(m_no_observer); }
+
+    /* Calls observer.on_step(ip, top, instruction) before executing every
+       instruction. Instantiated for NoObserver, OpcodeHistogram,
+       TraceRecorder and SampleProfiler. */
+    template <typename Observer>
+    void execute_step(Observer &observer);
+
+    /* Also true when stopped */
     bool terminated() const { return m_terminated; }
 
+    /* At a Break, which is executed again when resumed unless it has been
+       replaced. Breaks stop the VM as exiting does, so that loops only have
+       to check terminated(). */
+    bool stopped() const { return m_stopped; }
+
+    void resume();
+
+    /* For debuggers. Otherwise a Break can only be a corrupted instruction,
+       and throws */
+    void enable_breaks() { m_breaks = true; }
+
+    uint64_t steps() const { return m_steps; }
+
+    /* Byte address of the instruction executed next */
+    std::size_t ip() const { return m_ip; }
+
+    /* Frame of the running function: the return address is stored at the
+       base, and the base of the caller above it */
+    std::size_t base() const { return m_base; }
+
+    /* For host functions */
+    Memory &memory() { return m_memory; }
+
+    Output &output() { return m_output; }
+
+    /* The injected value i, or 0 if there are fewer */
+    uint32_t input(std::size_t i) const;
+
+    void terminate();
+
+    /* Snapshots hold the registers and the whole memory, code included */
+    void save(std::ostream &stream) const;
+
+    void load(std::istream &stream);
+
 private:
-    void execute_ecall(ECallFunction ecall);
+    static constexpr char SnapshotMagic[8] = "PIXSNAP";
+
+    static constexpr uint32_t SnapshotVersion = 2;
+
+    void execute_ecall(uint32_t index);
 
     void jump_to(std::size_t target);
 
     void jump_to_address(std::size_t target_addr);
 
+    NoObserver m_no_observer;
+
     Memory &m_memory;
 
+    Output &m_output;
+
+    std::vector<HostFunctions::Function> const &m_host_functions;
+
+    std::size_t m_inputs;
+
+    uint64_t m_steps;
+
     std::size_t m_ip;
 
     std::size_t m_base;
 
     bool m_terminated;
+
+    bool m_stopped;
+
+    bool m_breaks;
 };
 
 #endif
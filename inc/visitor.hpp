@@ -21,6 +21,10 @@ public:
 
     virtual Node &visit(NamedTypeAnnotation &anno);
 
+    virtual Node &visit(PointerTypeAnnotation &anno);
+
+    virtual Node &visit(ArrayTypeAnnotation &anno);
+
     virtual Node &visit(ScopedBlockStatement &stmt);
 
     virtual Node &visit(ExpressionStatement &stmt);
@@ -41,6 +45,8 @@ public:
 
     virtual Node &visit(BinaryExpression &expr);
 
+    virtual Node &visit(IndexExpression &expr);
+
     virtual Node &visit(Call &expr);
 
     virtual Node &visit(Variable &expr);
@@ -0,0 +1,84 @@
+#include "arena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+Arena::Arena(std::size_t block_size)
+        : m_blocks{}, m_finalizers{}, m_curr{nullptr}, m_end{nullptr},
+          m_block_size{block_size}, m_objects{}, m_bytes{} {}
+
+Arena::Arena(Arena &&other)
+        : m_blocks{std::move(other.m_blocks)},
+          m_finalizers{std::move(other.m_finalizers)},
+          m_curr{other.m_curr}, m_end{other.m_end},
+          m_block_size{other.m_block_size}, m_objects{other.m_objects},
+          m_bytes{other.m_bytes} {
+    other.m_blocks.clear();
+    other.m_finalizers.clear();
+    other.m_curr = other.m_end = nullptr;
+    other.m_objects = other.m_bytes = 0;
+}
+
+Arena &Arena::operator =(Arena &&other) {
+    if (this != &other) {
+        clear();
+
+        m_blocks = std::move(other.m_blocks);
+        m_finalizers = std::move(other.m_finalizers);
+        m_curr = other.m_curr;
+        m_end = other.m_end;
+        m_block_size = other.m_block_size;
+        m_objects = other.m_objects;
+        m_bytes = other.m_bytes;
+
+        other.m_blocks.clear();
+        other.m_finalizers.clear();
+        other.m_curr = other.m_end = nullptr;
+        other.m_objects = other.m_bytes = 0;
+    }
+
+    return *this;
+}
+
+Arena::~Arena() {
+    clear();
+}
+
+void Arena::clear() {
+    /* Destroy in reverse order, so objects may still refer to anything that
+       was allocated before them */
+    for (auto it = m_finalizers.rbegin(); it != m_finalizers.rend(); it++) {
+        it->destroy(it->object);
+    }
+
+    m_finalizers.clear();
+    m_blocks.clear();
+    m_curr = m_end = nullptr;
+    m_objects = 0;
+    m_bytes = 0;
+}
+
+void *Arena::allocate(std::size_t size, std::size_t align) {
+    std::uintptr_t curr = reinterpret_cast<std::uintptr_t>(m_curr);
+    std::uintptr_t aligned = (curr + align - 1) & ~(align - 1);
+
+    if (m_curr == nullptr
+            || aligned + size > reinterpret_cast<std::uintptr_t>(m_end)) {
+        add_block(size + align);
+
+        curr = reinterpret_cast<std::uintptr_t>(m_curr);
+        aligned = (curr + align - 1) & ~(align - 1);
+    }
+
+    m_curr = reinterpret_cast<char *>(aligned + size);
+    m_bytes += size;
+
+    return reinterpret_cast<void *>(aligned);
+}
+
+void Arena::add_block(std::size_t min_size) {
+    std::size_t size = std::max(m_block_size, min_size);
+
+    m_blocks.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+    m_curr = m_blocks.back().data.get();
+    m_end = m_curr + size;
+}
@@ -6,12 +6,12 @@
 
 Argument::Argument()
         : m_option{nullptr}, m_name{}, m_type{ArgType::Invalid},
-          m_init{}, m_value{} {}
+          m_init{}, m_value{}, m_required{false} {}
 
 Argument::Argument(void *option, std::string const &name, 
-                   ArgType type, std::string const &init)
+                   ArgType type, std::string const &init, bool required)
         : m_option{option}, m_name{name}, m_type{type}, 
-          m_init{init}, m_value{} {}
+          m_init{init}, m_value{}, m_required{required} {}
 
 void Argument::parse(ArgParser &args) {
     if (m_type == ArgType::Flag) {
@@ -43,7 +43,7 @@ void Argument::set_value(std::string const &value) {
 }
 
 void Argument::fill_option() {
-    if (m_type != ArgType::Flag && m_init.empty() && m_value.empty()) {
+    if (m_required && m_value.empty()) {
         std::stringstream ss;
         ss << "Required option `" << m_name << "` was not passed";
         throw std::runtime_error(ss.str());
@@ -74,7 +74,7 @@ ArgParser::ArgParser()
 
 void ArgParser::add_positional(void *option, std::string const &name, 
                                ArgType type, std::string const &init) {
-    m_positional_args.emplace_back(option, name, type, init);
+    m_positional_args.emplace_back(option, name, type, init, init.empty());
 }
 
 void ArgParser::add_keyword(void *option, std::string const &name, 
@@ -3,8 +3,10 @@
 #include <sstream>
 
 Assembler::Assembler(std::vector<CodeGenerator::entry_type> const &data, 
-                     Memory &memory)
-        : m_data{data}, m_labels{}, m_memory{memory} {}
+                     Memory &memory, std::size_t origin, 
+                     Label::map_type labels)
+        : m_data{data}, m_labels{std::move(labels)}, m_memory{memory}, 
+          m_origin{origin}, m_end{origin} {}
 
 void Assembler::assemble() {
     definition_pass();
@@ -12,29 +14,29 @@ void Assembler::assemble() {
 }
 
 void Assembler::definition_pass() {
-    m_labels.clear();
-
-    std::size_t p = 0;
+    std::size_t p = m_origin;
 
     for (CodeGenerator::entry_type const &entry : m_data) {
         if (std::holds_alternative<Instruction>(entry)) {
             p++;
         } else {
-            int id = std::get<Label>(entry).id();
+            Label const &label = std::get<Label>(entry);
 
-            if (m_labels.find(id) != m_labels.end()) {
+            if (m_labels.find(label.key()) != m_labels.end()) {
                 std::stringstream ss;
-                ss << "Redefined label: " << id;
+                ss << "Redefined label: " << label;
                 throw FatalError(ss.str());
             }
 
-            m_labels[id] = p;
+            m_labels[label.key()] = p;
         }
     }
+
+    m_end = p;
 }
 
 void Assembler::emission_pass() {
-    std::size_t p = 0;
+    std::size_t p = m_origin;
 
     for (CodeGenerator::entry_type const &entry : m_data) {
         if (std::holds_alternative<Instruction>(entry)) {
@@ -0,0 +1,868 @@
+#include "ast-serializer.hpp"
+#include "symbol-resolver.hpp"
+#include "host-functions.hpp"
+#include "utils.hpp"
+#include "error.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+enum class TypeTag {
+    Named,
+    Pointer,
+    Array
+};
+
+/* The types NamedType records refer to, by index */
+static std::vector<Type::unowned_ptr> const &named_types() {
+    static std::vector<Type::unowned_ptr> const types = {
+        Type::IntType(), Type::BoolType(), Type::WordType(),
+        Type::VoidType(), Type::ByteType(), Type::HalfType()
+    };
+    return types;
+}
+
+static void write_varint(std::ostream &stream, uint64_t value) {
+    while (value >= 0x80) {
+        stream.put(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    stream.put(static_cast<char>(value));
+}
+
+static uint64_t read_varint(std::istream &stream) {
+    uint64_t value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = stream.get();
+        if (byte == std::char_traits<char>::eof()) {
+            throw FatalError("read(): unexpected end of AST");
+        }
+
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+
+    throw FatalError("read(): malformed varint in AST");
+}
+
+/* Zigzag encoded, so that small negative values stay short */
+static void write_signed(std::ostream &stream, int64_t value) {
+    write_varint(stream, (static_cast<uint64_t>(value) << 1)
+                         ^ static_cast<uint64_t>(value >> 63));
+}
+
+static int64_t read_signed(std::istream &stream) {
+    uint64_t value = read_varint(stream);
+    return static_cast<int64_t>((value >> 1) ^ -(value & 1));
+}
+
+/* Space taken in an arena, whatever the alignment of what came before */
+static std::size_t arena_size(std::size_t size) {
+    std::size_t const align = alignof(std::max_align_t);
+    return (size + align - 1) / align * align;
+}
+
+/* The most arena space that a byte of the AST can ask for, since each node
+   and file name is written in a byte at least */
+static std::size_t max_arena_size() {
+    return arena_size(std::max({
+        sizeof(std::string), sizeof(ParameterDeclaration),
+        sizeof(FunctionDeclaration), sizeof(VariableDeclaration),
+        sizeof(NamedTypeAnnotation), sizeof(PointerTypeAnnotation),
+        sizeof(ArrayTypeAnnotation), sizeof(ScopedBlockStatement),
+        sizeof(ExpressionStatement), sizeof(AssignStatement),
+        sizeof(ReturnStatement), sizeof(IfElseStatement),
+        sizeof(WhileStatement), sizeof(BreakStatement),
+        sizeof(ContinueStatement), sizeof(UnaryExpression),
+        sizeof(BinaryExpression), sizeof(IndexExpression), sizeof(Call),
+        sizeof(Variable), sizeof(Integer), sizeof(BooleanLiteral)
+    }));
+}
+
+/* FNV-1a */
+static uint64_t checksum(std::string const &data) {
+    uint64_t hash = UINT64_C(0xCBF29CE484222325);
+    for (char c : data) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * UINT64_C(0x100000001B3);
+    }
+    return hash;
+}
+
+AstSerializer::AstSerializer(Program &program)
+        : m_program{program}, m_nodes{}, m_types{}, m_string_ids{},
+          m_strings{}, m_file_ids{}, m_files{}, m_type_ids{}, m_symbols{},
+          m_definitions{}, m_bytes{0} {
+    std::vector<FunctionDeclaration *> const &functions = program.functions();
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        m_definitions[&functions[i]->definition()] = i;
+    }
+
+    /* Lexemes that are the name of their kind are not stored */
+    string("");
+}
+
+void AstSerializer::write(std::ostream &stream, uint64_t source) {
+    write_list(m_program.stmts());
+
+    std::ostringstream rest;
+
+    write_varint(rest, m_strings.size());
+    for (std::string const &str : m_strings) {
+        write_varint(rest, str.size());
+        rest.write(str.data(), str.size());
+    }
+
+    write_varint(rest, m_files.size());
+    for (std::string const &fname : m_files) {
+        write_varint(rest, fname.size());
+        rest.write(fname.data(), fname.size());
+    }
+
+    write_varint(rest, m_type_ids.size());
+    rest << m_types.str();
+
+    write_varint(rest, m_program.functions().size());
+    rest << m_nodes.str();
+
+    std::string const data = rest.str();
+
+    stream.write(Magic, sizeof(Magic));
+    write_binary<uint32_t>(stream, Version);
+    write_binary<uint64_t>(stream, source);
+    write_binary<uint64_t>(stream,
+                           m_bytes + m_files.size()
+                                   * arena_size(sizeof(std::string)));
+    write_binary<uint64_t>(stream, checksum(data));
+    stream.write(data.data(), data.size());
+}
+
+template <typename T>
+void AstSerializer::begin(T &node) {
+    write_varint(m_nodes, static_cast<uint64_t>(node.kind()));
+    write_varint(m_nodes, type(node.type()));
+    m_bytes += arena_size(sizeof(T));
+}
+
+void AstSerializer::write_node(Node *node) {
+    if (node) {
+        node->accept(*this);
+    } else {
+        write_varint(m_nodes, static_cast<uint64_t>(NodeKind::None));
+    }
+}
+
+template <typename T>
+void AstSerializer::write_list(std::vector<T *> const &nodes) {
+    write_varint(m_nodes, nodes.size());
+    for (T *node : nodes) {
+        write_node(node);
+    }
+}
+
+void AstSerializer::write_token(Token const &token) {
+    std::string const &lexeme = token.lexeme();
+
+    write_varint(m_nodes, static_cast<uint64_t>(token.kind()));
+    write_varint(m_nodes, lexeme == to_string(token.kind()) ? 0
+                                                            : string(lexeme));
+    write_varint(m_nodes, file(token.pos().fname()));
+    write_varint(m_nodes, token.pos().line());
+    write_varint(m_nodes, token.pos().col());
+}
+
+/* Globals by id, locals by offset. Their type is that of the annotation of
+   their declaration. */
+void AstSerializer::write_symbol(VariableSymbol &symbol) {
+    uint32_t const index = m_symbols.size();
+    m_symbols[&symbol] = index;
+
+    if (auto *global = dynamic_cast<GlobalVariableSymbol *>(&symbol)) {
+        write_varint(m_nodes, 1);
+        write_varint(m_nodes, global->id());
+    } else {
+        write_varint(m_nodes, 0);
+        write_signed(m_nodes,
+                     static_cast<LocalVariableSymbol &>(symbol).offset());
+    }
+}
+
+uint32_t AstSerializer::string(std::string const &str) {
+    auto [it, inserted] = m_string_ids.emplace(str, m_strings.size());
+    if (inserted) {
+        m_strings.push_back(str);
+    }
+    return it->second;
+}
+
+uint32_t AstSerializer::file(std::string const &fname) {
+    auto [it, inserted] = m_file_ids.emplace(fname, m_files.size());
+    if (inserted) {
+        m_files.push_back(fname);
+    }
+    return it->second;
+}
+
+/* Targets are written before the types that refer to them */
+uint32_t AstSerializer::type(Type::unowned_ptr type) {
+    if (!type) {
+        return 0;
+    }
+
+    auto it = m_type_ids.find(type);
+    if (it != m_type_ids.end()) {
+        return it->second;
+    }
+
+    std::vector<Type::unowned_ptr> const &named = named_types();
+    auto named_it = std::find(named.begin(), named.end(), type);
+
+    if (named_it != named.end()) {
+        write_varint(m_types, static_cast<uint64_t>(TypeTag::Named));
+        write_varint(m_types, named_it - named.begin());
+    } else if (auto *pointer = dynamic_cast<PointerType *>(type)) {
+        uint32_t target = this->type(pointer->target());
+        write_varint(m_types, static_cast<uint64_t>(TypeTag::Pointer));
+        write_varint(m_types, target);
+    } else if (auto *array = dynamic_cast<ArrayType *>(type)) {
+        uint32_t target = this->type(array->target());
+        write_varint(m_types, static_cast<uint64_t>(TypeTag::Array));
+        write_varint(m_types, target);
+        write_varint(m_types, array->length());
+    } else {
+        std::stringstream ss;
+        ss << "write(): cannot serialize type " << *type;
+        throw FatalError(ss.str());
+    }
+
+    uint32_t const id = m_type_ids.size() + 1;
+    m_type_ids[type] = id;
+    return id;
+}
+
+/* The parameters are written in place, with the symbols of the definition.
+   Its type is made up of the annotations again when reading. */
+Node &AstSerializer::visit(FunctionDeclaration &decl) {
+    FunctionDefinition &def = decl.definition();
+
+    begin(decl);
+    write_token(decl.func());
+
+    write_varint(m_nodes, decl.params().size());
+    for (std::size_t i = 0; i < decl.params().size(); i++) {
+        ParameterDeclaration &param = *decl.params()[i];
+
+        begin(param);
+        write_token(param.ident());
+        write_node(param.annotation());
+        write_symbol(*def.params()[i]);
+    }
+
+    write_node(decl.ret_type_annotation());
+    write_list(decl.body());
+
+    write_varint(m_nodes, def.locals().size());
+    for (LocalVariableSymbol::unowned_ptr local : def.locals()) {
+        write_varint(m_nodes, m_symbols.at(local));
+    }
+
+    return decl;
+}
+
+Node &AstSerializer::visit(VariableDeclaration &decl) {
+    begin(decl);
+    write_token(decl.ident());
+    write_node(decl.annotation());
+    write_node(decl.value());
+    write_symbol(decl.symbol());
+    return decl;
+}
+
+Node &AstSerializer::visit(NamedTypeAnnotation &anno) {
+    begin(anno);
+    write_token(anno.ident());
+    return anno;
+}
+
+Node &AstSerializer::visit(PointerTypeAnnotation &anno) {
+    begin(anno);
+    write_token(anno.star());
+    write_node(anno.target());
+    return anno;
+}
+
+Node &AstSerializer::visit(ArrayTypeAnnotation &anno) {
+    begin(anno);
+    write_node(anno.target());
+    write_token(anno.length());
+    return anno;
+}
+
+Node &AstSerializer::visit(ScopedBlockStatement &stmt) {
+    begin(stmt);
+    write_list(stmt.body());
+    return stmt;
+}
+
+Node &AstSerializer::visit(ExpressionStatement &stmt) {
+    begin(stmt);
+    write_node(stmt.expr());
+    return stmt;
+}
+
+Node &AstSerializer::visit(AssignStatement &stmt) {
+    begin(stmt);
+    write_node(stmt.target());
+    write_node(stmt.value());
+    return stmt;
+}
+
+Node &AstSerializer::visit(ReturnStatement &stmt) {
+    begin(stmt);
+    write_node(stmt.value());
+    return stmt;
+}
+
+Node &AstSerializer::visit(IfElseStatement &stmt) {
+    begin(stmt);
+    write_node(stmt.condition());
+    write_node(stmt.then_stmt());
+    write_node(stmt.else_stmt());
+    return stmt;
+}
+
+Node &AstSerializer::visit(WhileStatement &stmt) {
+    begin(stmt);
+    write_node(stmt.condition());
+    write_node(stmt.loop_stmt());
+    return stmt;
+}
+
+Node &AstSerializer::visit(BreakStatement &stmt) {
+    begin(stmt);
+    write_token(stmt.token());
+    return stmt;
+}
+
+Node &AstSerializer::visit(ContinueStatement &stmt) {
+    begin(stmt);
+    write_token(stmt.token());
+    return stmt;
+}
+
+Node &AstSerializer::visit(UnaryExpression &expr) {
+    begin(expr);
+    write_token(expr.op());
+    write_node(expr.operand());
+    return expr;
+}
+
+Node &AstSerializer::visit(BinaryExpression &expr) {
+    begin(expr);
+    write_token(expr.op());
+    write_node(expr.left());
+    write_node(expr.right());
+    return expr;
+}
+
+Node &AstSerializer::visit(IndexExpression &expr) {
+    begin(expr);
+    write_node(expr.base());
+    write_node(expr.index());
+    write_varint(m_nodes, expr.width());
+    return expr;
+}
+
+/* Host functions come after the functions of the program */
+Node &AstSerializer::visit(Call &expr) {
+    FunctionDefinition &called = expr.called();
+
+    begin(expr);
+    write_token(expr.func());
+    write_list(expr.args());
+    write_varint(m_nodes, called.is_ecall()
+                          ? m_program.functions().size()
+                                    + static_cast<std::size_t>(called.ecall())
+                          : m_definitions.at(&called));
+    return expr;
+}
+
+Node &AstSerializer::visit(Variable &expr) {
+    begin(expr);
+    write_token(expr.ident());
+    write_varint(m_nodes, m_symbols.at(&expr.symbol()));
+    return expr;
+}
+
+Node &AstSerializer::visit(Integer &expr) {
+    begin(expr);
+    write_token(expr.literal());
+    return expr;
+}
+
+Node &AstSerializer::visit(BooleanLiteral &literal) {
+    begin(literal);
+    write_token(literal.literal());
+    return literal;
+}
+
+AstDeserializer::AstDeserializer(std::istream &stream)
+        : m_stream{}, m_size{0}, m_source{0}, m_bytes{0}, m_strings{},
+          m_file_names{}, m_files{}, m_types{}, m_symbols{},
+          m_definitions{}, m_functions{0}, m_calls{}, m_program{nullptr},
+          m_scope{} {
+    char magic[sizeof(AstSerializer::Magic)];
+    if (!stream.read(magic, sizeof(magic))
+            || std::memcmp(magic, AstSerializer::Magic, sizeof(magic)) != 0) {
+        throw FatalError("AstDeserializer(): not an AST");
+    }
+
+    if (read_binary<uint32_t>(stream) != AstSerializer::Version) {
+        throw FatalError("AstDeserializer(): unsupported AST version");
+    }
+
+    m_source = read_binary<uint64_t>(stream);
+    m_bytes = read_binary<uint64_t>(stream);
+    uint64_t const sum = read_binary<uint64_t>(stream);
+
+    std::string const data{std::istreambuf_iterator<char>(stream),
+                           std::istreambuf_iterator<char>()};
+    if (!stream || checksum(data) != sum) {
+        throw FatalError("AstDeserializer(): corrupt AST");
+    }
+
+    m_stream.str(data);
+    m_size = data.size();
+
+    if (m_bytes > m_size * max_arena_size()) {
+        throw FatalError("AstDeserializer(): arena size out of range in AST");
+    }
+
+    for (std::vector<std::string> *table : { &m_strings, &m_file_names }) {
+        table->resize(read_count("table"));
+
+        for (std::string &str : *table) {
+            str.resize(read_count("string"));
+            if (!m_stream.read(str.data(), str.size())) {
+                throw FatalError("AstDeserializer(): unexpected end of AST");
+            }
+        }
+    }
+
+    /* Type 0 is none */
+    m_types.resize(read_count("type table") + 1);
+    for (std::size_t i = 1; i < m_types.size(); i++) {
+        TypeTag tag = static_cast<TypeTag>(read_varint(m_stream));
+
+        if (tag == TypeTag::Named) {
+            m_types[i] = named_types().at(read_index(named_types().size(),
+                                                     "named type"));
+        } else if (tag == TypeTag::Pointer) {
+            m_types[i] = PointerType::Get(read_target(i));
+        } else if (tag == TypeTag::Array) {
+            Type::unowned_ptr target = read_target(i);
+            m_types[i] = ArrayType::Get(target, read_index(
+                    std::numeric_limits<int>::max() + UINT64_C(1),
+                    "array length"));
+        } else {
+            throw FatalError("AstDeserializer(): unknown type in AST");
+        }
+    }
+
+    m_functions = read_count("function table");
+}
+
+Program::ptr AstDeserializer::read() {
+    Program::ptr program = std::make_unique<Program>(
+            Arena(std::max<std::size_t>(m_bytes, 1)),
+            std::vector<Statement::ptr>());
+    m_program = program.get();
+
+    for (std::string const &fname : m_file_names) {
+        m_files.push_back(program->arena().create<std::string>(fname));
+    }
+
+    m_scope.enter(program->symbols());
+    SymbolResolver::declare_builtins(m_scope);
+
+    /* The definitions of the host functions are those just declared */
+    std::vector<HostFunctions::Function> const &host_functions
+            = HostFunctions::registry().functions();
+    m_definitions.resize(m_functions + host_functions.size());
+
+    for (std::size_t i = 0; i < host_functions.size(); i++) {
+        if (host_functions[i].name.empty()) {
+            continue;
+        }
+
+        auto *symbol = dynamic_cast<FunctionSymbol *>(program->symbols()
+                .lookup(Interner::intern(host_functions[i].name)));
+        if (!symbol) {
+            continue;
+        }
+
+        for (FunctionDefinition::ptr &def : symbol->definitions()) {
+            if (def->is_ecall()
+                    && static_cast<std::size_t>(def->ecall()) == i) {
+                m_definitions[m_functions + i] = def.get();
+            }
+        }
+    }
+
+    program->stmts() = read_list<Statement>();
+    m_scope.leave(program->symbols());
+
+    if (program->functions().size() != m_functions) {
+        throw FatalError("read(): wrong number of functions in AST");
+    }
+
+    for (auto const &[call, index] : m_calls) {
+        if (!m_definitions[index]) {
+            throw FatalError("read(): call of an unknown function in AST");
+        }
+        call->set_called(*m_definitions[index]);
+    }
+
+    return program;
+}
+
+Node::ptr AstDeserializer::read_node() {
+    NodeKind kind = static_cast<NodeKind>(read_index(
+            static_cast<std::size_t>(NodeKind::BooleanLiteral) + 1,
+            "node kind"));
+    if (kind == NodeKind::None) {
+        return nullptr;
+    }
+
+    Type::unowned_ptr type = read_type();
+    Arena &arena = m_program->arena();
+    Node::ptr node = nullptr;
+
+    switch (kind) {
+        case NodeKind::FunctionDeclaration:
+            node = read_function(read_identifier());
+            break;
+        case NodeKind::VariableDeclaration:
+            node = read_variable(read_identifier());
+            break;
+        case NodeKind::NamedTypeAnnotation:
+            node = arena.create<NamedTypeAnnotation>(read_token());
+            break;
+        case NodeKind::PointerTypeAnnotation: {
+            Token star = read_token();
+            node = arena.create<PointerTypeAnnotation>(
+                    star, read_child<TypeAnnotation>());
+            break;
+        }
+        case NodeKind::ArrayTypeAnnotation: {
+            TypeAnnotation::ptr target = read_child<TypeAnnotation>();
+            node = arena.create<ArrayTypeAnnotation>(target,
+                                                     read_integer());
+            break;
+        }
+        case NodeKind::ScopedBlockStatement:
+            node = read_block();
+            break;
+        case NodeKind::ExpressionStatement:
+            node = arena.create<ExpressionStatement>(
+                    read_child<Expression>());
+            break;
+        case NodeKind::AssignStatement: {
+            Expression::ptr target = read_child<Expression>();
+            node = arena.create<AssignStatement>(target,
+                                                 read_child<Expression>());
+            break;
+        }
+        case NodeKind::ReturnStatement:
+            node = arena.create<ReturnStatement>(read_child<Expression>());
+            break;
+        case NodeKind::IfElseStatement: {
+            Expression::ptr condition = read_child<Expression>();
+            Statement::ptr then_stmt = read_child<Statement>();
+            node = arena.create<IfElseStatement>(condition, then_stmt,
+                                                 read_child<Statement>());
+            break;
+        }
+        case NodeKind::WhileStatement: {
+            Expression::ptr condition = read_child<Expression>();
+            node = arena.create<WhileStatement>(condition,
+                                                read_child<Statement>());
+            break;
+        }
+        case NodeKind::BreakStatement:
+            node = arena.create<BreakStatement>(read_token());
+            break;
+        case NodeKind::ContinueStatement:
+            node = arena.create<ContinueStatement>(read_token());
+            break;
+        case NodeKind::UnaryExpression: {
+            Token op = read_token();
+            node = arena.create<UnaryExpression>(op,
+                                                 read_child<Expression>());
+            break;
+        }
+        case NodeKind::BinaryExpression: {
+            Token op = read_token();
+            Expression::ptr left = read_child<Expression>();
+            node = arena.create<BinaryExpression>(op, left,
+                                                  read_child<Expression>());
+            break;
+        }
+        case NodeKind::IndexExpression: {
+            Expression::ptr base = read_child<Expression>();
+            IndexExpression *index = arena.create<IndexExpression>(
+                    base, read_child<Expression>());
+            uint64_t width = read_varint(m_stream);
+            if (width != 1 && width != 2 && width != 4) {
+                throw FatalError("read(): width out of range in AST");
+            }
+            index->set_width(width);
+            node = index;
+            break;
+        }
+        case NodeKind::Call: {
+            Token func = read_token();
+            Call *call = arena.create<Call>(func, read_list<Expression>());
+            m_calls.emplace_back(call, read_index(m_definitions.size(),
+                                                  "function"));
+            node = call;
+            break;
+        }
+        case NodeKind::Variable: {
+            Variable *var = arena.create<Variable>(read_token());
+            var->set_symbol(*m_symbols[read_index(m_symbols.size(),
+                                                  "variable")]);
+            node = var;
+            break;
+        }
+        case NodeKind::Integer:
+            node = arena.create<Integer>(read_integer());
+            break;
+        case NodeKind::BooleanLiteral:
+            node = arena.create<BooleanLiteral>(read_token());
+            break;
+        default:
+            throw FatalError("read(): unexpected node in AST: "
+                             + to_string(kind));
+    }
+
+    /* All but statements were typed by the passes */
+    if (!type && !dynamic_cast<Statement *>(node)) {
+        throw FatalError("read(): untyped node in AST: " + to_string(kind));
+    }
+
+    node->set_type(type);
+    return node;
+}
+
+template <typename T>
+T *AstDeserializer::read_child(bool nullable) {
+    Node::ptr node = read_node();
+    T *child = dynamic_cast<T *>(node);
+
+    if (!node && !nullable) {
+        throw FatalError("read(): missing node in AST");
+    } else if (node && !child) {
+        throw FatalError("read(): misplaced node in AST: "
+                         + to_string(node->kind()));
+    }
+
+    return child;
+}
+
+template <typename T>
+std::vector<T *> AstDeserializer::read_list() {
+    std::vector<T *> nodes(read_count("list"));
+    for (T *&node : nodes) {
+        node = read_child<T>();
+    }
+    return nodes;
+}
+
+/* Declared in its scope once it has been read, as by the SymbolResolver */
+FunctionDeclaration *AstDeserializer::read_function(Token const &func) {
+    Arena &arena = m_program->arena();
+    FunctionDeclaration *decl = arena.create<FunctionDeclaration>(
+            func, std::vector<ParameterDeclaration::ptr>(), nullptr,
+            std::vector<Statement::ptr>());
+    m_program->functions().push_back(decl);
+    std::size_t const index = m_program->functions().size() - 1;
+
+    decl->symbols().set_parent(&m_scope.current());
+    m_scope.enter(decl->symbols());
+
+    std::vector<LocalVariableSymbol::unowned_ptr> params;
+    std::vector<Type::unowned_ptr> param_types;
+
+    decl->params().resize(read_count("parameter list"));
+    for (ParameterDeclaration::ptr &param : decl->params()) {
+        if (static_cast<NodeKind>(read_varint(m_stream))
+                != NodeKind::ParameterDeclaration) {
+            throw FatalError("read(): expected a parameter in AST");
+        }
+
+        Type::unowned_ptr type = read_type();
+        Token ident = read_identifier();
+        param = arena.create<ParameterDeclaration>(
+                ident, read_child<TypeAnnotation>());
+        param->set_type(type);
+
+        VariableSymbol::ptr symbol = read_symbol(param->annotation());
+        auto *local = dynamic_cast<LocalVariableSymbol *>(symbol.get());
+        if (!local) {
+            throw FatalError("read(): global parameter in AST");
+        }
+
+        params.push_back(local);
+        param_types.push_back(param->annotation()->type());
+        m_scope.declare(param->ident(), std::move(symbol));
+    }
+
+    decl->ret_type_annotation() = read_child<TypeAnnotation>();
+    decl->body() = read_list<Statement>();
+
+    std::vector<LocalVariableSymbol::unowned_ptr> locals(
+            read_count("variable list"));
+    for (LocalVariableSymbol::unowned_ptr &local : locals) {
+        local = dynamic_cast<LocalVariableSymbol *>(
+                m_symbols[read_index(m_symbols.size(), "variable")]);
+        if (!local) {
+            throw FatalError("read(): global local variable in AST");
+        }
+    }
+
+    m_scope.leave(decl->symbols());
+
+    FunctionType::ptr type = std::make_unique<FunctionType>(
+            param_types, decl->ret_type_annotation()->type());
+
+    FunctionDefinition def(std::move(type), decl, params, locals);
+    decl->set_definition(m_scope.declare_function(decl->func(),
+                                                  std::move(def)));
+    m_definitions[index] = &decl->definition();
+
+    return decl;
+}
+
+VariableDeclaration *AstDeserializer::read_variable(Token const &ident) {
+    TypeAnnotation::ptr annotation = read_child<TypeAnnotation>();
+    VariableDeclaration *decl = m_program->arena()
+            .create<VariableDeclaration>(ident, annotation,
+                                         read_child<Expression>(true));
+
+    VariableSymbol::ptr symbol = read_symbol(annotation);
+    decl->set_symbol(*symbol);
+    if (auto *global = dynamic_cast<GlobalVariableSymbol *>(symbol.get())) {
+        m_program->globals().push_back(global);
+    }
+    m_scope.declare(decl->ident(), std::move(symbol));
+
+    return decl;
+}
+
+ScopedBlockStatement *AstDeserializer::read_block() {
+    ScopedBlockStatement *stmt = m_program->arena()
+            .create<ScopedBlockStatement>(std::vector<Statement::ptr>());
+
+    stmt->symbols().set_parent(&m_scope.current());
+    m_scope.enter(stmt->symbols());
+    stmt->body() = read_list<Statement>();
+    m_scope.leave(stmt->symbols());
+
+    return stmt;
+}
+
+Token AstDeserializer::read_token() {
+    TokenKind kind = static_cast<TokenKind>(read_index(
+            static_cast<std::size_t>(TokenKind::EndOfFile) + 1,
+            "token kind"));
+    std::string lexeme = read_string();
+    std::string const &fname = *m_files[read_index(m_files.size(), "file")];
+    std::size_t line = read_varint(m_stream);
+    std::size_t col = read_varint(m_stream);
+
+    return Token(TextPosition(fname, line, col), kind, std::move(lexeme));
+}
+
+Token AstDeserializer::read_identifier() {
+    Token token = read_token();
+    if (token.kind() != TokenKind::Identifier || token.id() == 0) {
+        throw FatalError("read(): malformed identifier in AST");
+    }
+    return token;
+}
+
+Token AstDeserializer::read_integer() {
+    Token token = read_token();
+    bool valid = token.kind() == TokenKind::Integer;
+
+    try {
+        valid = valid && std::stoi(token.lexeme()) >= 0;
+    } catch (std::exception const &) {
+        valid = false;
+    }
+
+    if (!valid) {
+        throw FatalError("read(): malformed integer in AST");
+    }
+    return token;
+}
+
+std::string const &AstDeserializer::read_string() {
+    return m_strings[read_index(m_strings.size(), "string")];
+}
+
+Type::unowned_ptr AstDeserializer::read_type() {
+    return m_types[read_index(m_types.size(), "type")];
+}
+
+Type::unowned_ptr AstDeserializer::read_target(std::size_t type) {
+    Type::unowned_ptr target = m_types[read_index(type, "type target")];
+    if (!target) {
+        throw FatalError("AstDeserializer(): type without a target");
+    }
+    return target;
+}
+
+VariableSymbol::ptr AstDeserializer::read_symbol(
+        TypeAnnotation::ptr annotation) {
+    VariableSymbol::ptr symbol;
+    if (read_varint(m_stream)) {
+        symbol = std::make_unique<GlobalVariableSymbol>(
+                annotation->type(), read_varint(m_stream));
+    } else {
+        auto local = std::make_unique<LocalVariableSymbol>(annotation->type());
+        local->set_offset(read_signed(m_stream));
+        symbol = std::move(local);
+    }
+
+    m_symbols.push_back(symbol.get());
+    return symbol;
+}
+
+uint64_t AstDeserializer::read_index(std::size_t size, char const *what) {
+    uint64_t index = read_varint(m_stream);
+    if (index >= size) {
+        throw FatalError(std::string("read(): ") + what
+                         + " out of range in AST");
+    }
+    return index;
+}
+
+uint64_t AstDeserializer::read_count(char const *what) {
+    uint64_t count = read_varint(m_stream);
+    if (count > remaining()) {
+        throw FatalError(std::string("read(): ") + what
+                         + " too long for AST");
+    }
+    return count;
+}
+
+std::size_t AstDeserializer::remaining() {
+    std::streamoff const pos = m_stream.tellg();
+    return pos < 0 ? 0 : m_size - static_cast<std::size_t>(pos);
+}
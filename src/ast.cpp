@@ -11,6 +11,8 @@ std::string const &to_string(NodeKind kind) {
         { NodeKind::FunctionDeclaration, "function-declaration" },
         { NodeKind::VariableDeclaration, "variable-declaration" },
         { NodeKind::NamedTypeAnnotation, "named-type-annotation" },
+        { NodeKind::PointerTypeAnnotation, "pointer-type-annotation" },
+        { NodeKind::ArrayTypeAnnotation, "array-type-annotation" },
         { NodeKind::ScopedBlockStatement, "scoped-block-statement" },
         { NodeKind::ExpressionStatement, "expression-statement" },
         { NodeKind::AssignStatement, "assign-statement" },
@@ -21,6 +23,7 @@ std::string const &to_string(NodeKind kind) {
         { NodeKind::ContinueStatement, "continue-statement" },
         { NodeKind::UnaryExpression, "unary-expression" },
         { NodeKind::BinaryExpression, "binary-expression" },
+        { NodeKind::IndexExpression, "index-expression" },
         { NodeKind::Call, "call" },
         { NodeKind::Variable, "variable" },
         { NodeKind::Integer, "integer" },
@@ -46,77 +49,83 @@ Node::Node()
         : m_type{} {}
 
 template <typename T>
-JSONList::ptr Node::to_json_list(std::vector<T> const &list) {
-    JSONList::ptr json_list = JSONList::Create();
+void Node::write_json_list(JSONWriter &writer, std::vector<T> const &list) {
+    writer.begin_list();
 
     for (T const &entry : list) {
-        json_list->add(entry->to_json());
+        entry->write_json(writer);
     }
 
-    return json_list;
+    writer.end_list();
 }
 
 Statement::Statement() 
         : Node{} {}
 
-JSON::ptr Statement::to_json() const {
-    JSONObject::ptr object = JSONObject::Create();
+void Statement::write_json(JSONWriter &writer) const {
+    writer.begin_object();
 
-    object->add_key("kind", JSONString::Create(to_string(kind())));
-    add_json_attributes(*object);
+    writer.field("kind", to_string(kind()));
+    write_json_attributes(writer);
 
-    return object;
+    writer.end_object();
 }
 
 Expression::Expression() 
         : Node{} {}
 
-JSON::ptr Expression::to_json() const {
-    JSONObject::ptr object = JSONObject::Create();
+void Expression::write_json(JSONWriter &writer) const {
+    writer.begin_object();
 
-    object->add_key("kind", JSONString::Create(to_string(kind())));
+    writer.field("kind", to_string(kind()));
     if (m_type != nullptr) {
-        object->add_key("type", m_type->to_json());
+        writer.key("type");
+        m_type->write_json(writer);
     }
-    add_json_attributes(*object);
+    write_json_attributes(writer);
 
-    return object;
+    writer.end_object();
 }
 
 TypeAnnotation::TypeAnnotation()
         {}
 
-JSON::ptr TypeAnnotation::to_json() const {
-    JSONObject::ptr object = JSONObject::Create();
+void TypeAnnotation::write_json(JSONWriter &writer) const {
+    writer.begin_object();
 
-    object->add_key("kind", JSONString::Create(to_string(kind())));
+    writer.field("kind", to_string(kind()));
     if (m_type != nullptr) {
-        object->add_key("type", m_type->to_json());
+        writer.key("type");
+        m_type->write_json(writer);
     }
-    add_json_attributes(*object);
+    write_json_attributes(writer);
 
-    return object;
+    writer.end_object();
 }
 
-Program::Program(std::vector<Statement::ptr> stmts)
-        : Node{}, m_stmts{std::move(stmts)}, m_symbols{} {}
+Program::Program(Arena arena, std::vector<Statement::ptr> stmts)
+        : Node{}, m_arena{std::move(arena)},
+          m_stmts{std::move(stmts)}, m_symbols{}, m_functions{},
+          m_globals{} {}
 
-JSON::ptr Program::to_json() const {
-    JSONObject::ptr object = JSONObject::Create();
+void Program::write_json(JSONWriter &writer) const {
+    writer.begin_object();
 
-    object->add_key("kind", JSONString::Create(to_string(kind())));
-    object->add_key("stmts", Node::to_json_list(m_stmts));
+    writer.field("kind", to_string(kind()));
+    writer.key("stmts");
+    Node::write_json_list(writer, m_stmts);
 
-    return object;
+    writer.end_object();
 }
 
 ParameterDeclaration::ParameterDeclaration(Token const &ident, 
                                            TypeAnnotation::ptr annotation)
-        : m_ident{ident}, m_annotation{std::move(annotation)} {}
+        : m_ident{ident}, m_annotation{annotation} {}
 
-void ParameterDeclaration::add_json_attributes(JSONObject &object) const {
-    object.add_key("identifier", JSONString::Create(m_ident.lexeme()));
-    object.add_key("annotation", m_annotation->to_json());
+void ParameterDeclaration::write_json_attributes(JSONWriter &writer) const {
+    writer.field("identifier", m_ident.lexeme());
+    writer.key("annotation");
+    m_annotation->write_json(writer);
 }
 
 FunctionDeclaration::FunctionDeclaration(Token const &func, 
@@ -124,83 +133,118 @@ FunctionDeclaration::FunctionDeclaration(Token const &func,
                                          TypeAnnotation::ptr ret_type_annotation,
                                          std::vector<Statement::ptr> body)
         : m_func{func}, m_params{std::move(params)}, 
-          m_ret_type_annotation{std::move(ret_type_annotation)}, 
+          m_ret_type_annotation{ret_type_annotation}, 
           m_body{std::move(body)} {}
 
-void FunctionDeclaration::add_json_attributes(JSONObject &object) const {
-    object.add_key("function", JSONString::Create(m_func.lexeme()));
-    object.add_key("params", Node::to_json_list(m_params));
-    object.add_key("body", Node::to_json_list(m_body));
+void FunctionDeclaration::write_json_attributes(JSONWriter &writer) const {
+    writer.field("function", m_func.lexeme());
+    writer.key("params");
+    Node::write_json_list(writer, m_params);
+    writer.key("body");
+    Node::write_json_list(writer, m_body);
 }
 
 VariableDeclaration::VariableDeclaration(Token const &ident, 
                                          TypeAnnotation::ptr annotation, 
                                          Expression::ptr value)
-        : m_ident{ident}, m_annotation{std::move(annotation)},
-          m_value{std::move(value)} {}
-
-void VariableDeclaration::add_json_attributes(JSONObject &object) const {
-    object.add_key("identifier", JSONString::Create(m_ident.lexeme()));
-    object.add_key("annotation", m_annotation->to_json());
-    object.add_key("value", m_value->to_json());
+        : m_ident{ident}, m_annotation{annotation},
+          m_value{value}, m_symbol{nullptr} {}
+
+void VariableDeclaration::write_json_attributes(JSONWriter &writer) const {
+    writer.field("identifier", m_ident.lexeme());
+    writer.key("annotation");
+    m_annotation->write_json(writer);
+    if (m_value) {
+        writer.key("value");
+        m_value->write_json(writer);
+    }
 }
 
 NamedTypeAnnotation::NamedTypeAnnotation(Token const &ident)
         : TypeAnnotation{}, m_ident{ident} {}
 
-void NamedTypeAnnotation::add_json_attributes(JSONObject &object) const {
-    object.add_key("identifier", JSONString::Create(m_ident.lexeme()));
+void NamedTypeAnnotation::write_json_attributes(JSONWriter &writer) const {
+    writer.field("identifier", m_ident.lexeme());
+}
+
+PointerTypeAnnotation::PointerTypeAnnotation(Token const &star,
+                                             TypeAnnotation::ptr target)
+        : TypeAnnotation{}, m_star{star}, m_target{target} {}
+
+void PointerTypeAnnotation::write_json_attributes(JSONWriter &writer) const {
+    writer.key("target");
+    m_target->write_json(writer);
+}
+
+ArrayTypeAnnotation::ArrayTypeAnnotation(TypeAnnotation::ptr target,
+                                         Token const &length)
+        : TypeAnnotation{}, m_target{target}, m_length{length} {}
+
+void ArrayTypeAnnotation::write_json_attributes(JSONWriter &writer) const {
+    writer.key("target");
+    m_target->write_json(writer);
+    writer.field("length", std::stoi(m_length.lexeme()));
 }
 
 ScopedBlockStatement::ScopedBlockStatement(std::vector<Statement::ptr> body)
         : m_body{std::move(body)}, m_symbols{} {}
 
-void ScopedBlockStatement::add_json_attributes(JSONObject &object) const {
-    object.add_key("body", Node::to_json_list(m_body));
+void ScopedBlockStatement::write_json_attributes(JSONWriter &writer) const {
+    writer.key("body");
+    Node::write_json_list(writer, m_body);
 }
 
 ExpressionStatement::ExpressionStatement(Expression::ptr expr)
-        : Statement{}, m_expr{std::move(expr)} {}
+        : Statement{}, m_expr{expr} {}
 
-void ExpressionStatement::add_json_attributes(JSONObject &object) const {
-    object.add_key("expr", m_expr->to_json());
+void ExpressionStatement::write_json_attributes(JSONWriter &writer) const {
+    writer.key("expr");
+    m_expr->write_json(writer);
 }
 
 AssignStatement::AssignStatement(Expression::ptr target, Expression::ptr value)
-        : m_target{std::move(target)}, m_value{std::move(value)} {}
+        : m_target{target}, m_value{value} {}
 
-void AssignStatement::add_json_attributes(JSONObject &object) const {
-    object.add_key("target", m_target->to_json());
-    object.add_key("value", m_value->to_json());
+void AssignStatement::write_json_attributes(JSONWriter &writer) const {
+    writer.key("target");
+    m_target->write_json(writer);
+    writer.key("value");
+    m_value->write_json(writer);
 }
 
 ReturnStatement::ReturnStatement(Expression::ptr value)
-        : m_value{std::move(value)} {}
+        : m_value{value} {}
 
-void ReturnStatement::add_json_attributes(JSONObject &object) const {
-    object.add_key("value", m_value->to_json());
+void ReturnStatement::write_json_attributes(JSONWriter &writer) const {
+    writer.key("value");
+    m_value->write_json(writer);
 }
 
 IfElseStatement::IfElseStatement(Expression::ptr condition, 
                                  Statement::ptr then_stmt, 
                                  Statement::ptr else_stmt)
-        : m_condition{std::move(condition)}, m_then_stmt{std::move(then_stmt)}, 
-          m_else_stmt{std::move(else_stmt)} {}
-
-void IfElseStatement::add_json_attributes(JSONObject &object) const {
-    object.add_key("condition", m_condition->to_json());
-    object.add_key("then-stmt", m_then_stmt->to_json());
-    object.add_key("else-stmt", m_else_stmt->to_json());
+        : m_condition{condition}, m_then_stmt{then_stmt}, 
+          m_else_stmt{else_stmt} {}
+
+void IfElseStatement::write_json_attributes(JSONWriter &writer) const {
+    writer.key("condition");
+    m_condition->write_json(writer);
+    writer.key("then-stmt");
+    m_then_stmt->write_json(writer);
+    writer.key("else-stmt");
+    m_else_stmt->write_json(writer);
 }
 
 WhileStatement::WhileStatement(Expression::ptr condition, 
                                Statement::ptr loop_stmt)
-        : m_condition{std::move(condition)}, 
-          m_loop_stmt{std::move(loop_stmt)} {}
-
-void WhileStatement::add_json_attributes(JSONObject &object) const {
-    object.add_key("condition", m_condition->to_json());
-    object.add_key("loop-stmt", m_loop_stmt->to_json());
+        : m_condition{condition}, 
+          m_loop_stmt{loop_stmt} {}
+
+void WhileStatement::write_json_attributes(JSONWriter &writer) const {
+    writer.key("condition");
+    m_condition->write_json(writer);
+    writer.key("loop-stmt");
+    m_loop_stmt->write_json(writer);
 }
 
 BreakStatement::BreakStatement(Token const &token)
@@ -210,50 +254,64 @@ ContinueStatement::ContinueStatement(Token const &token)
         : m_token{token} {}
 
 UnaryExpression::UnaryExpression(Token const &op, Expression::ptr operand)
-        : m_op{op}, m_operand{std::move(operand)} {}
+        : m_op{op}, m_operand{operand} {}
 
-void UnaryExpression::add_json_attributes(JSONObject &object) const {
-    object.add_key("operator", JSONString::Create(m_op.lexeme()));
-    object.add_key("operand", m_operand->to_json());
+void UnaryExpression::write_json_attributes(JSONWriter &writer) const {
+    writer.field("operator", m_op.lexeme());
+    writer.key("operand");
+    m_operand->write_json(writer);
 }
 
 BinaryExpression::BinaryExpression(Token const &op, Expression::ptr left, 
                                    Expression::ptr right)
-        : m_op{op}, m_left{std::move(left)}, m_right{std::move(right)} {}
+        : m_op{op}, m_left{left}, m_right{right} {}
+
+void BinaryExpression::write_json_attributes(JSONWriter &writer) const {
+    writer.field("operator", m_op.lexeme());
+    writer.key("left");
+    m_left->write_json(writer);
+    writer.key("right");
+    m_right->write_json(writer);
+}
+
+IndexExpression::IndexExpression(Expression::ptr base, Expression::ptr index)
+        : Expression{}, m_base{base}, m_index{index}, m_width{0} {}
 
-void BinaryExpression::add_json_attributes(JSONObject &object) const {
-    object.add_key("operator", JSONString::Create(m_op.lexeme()));
-    object.add_key("left", m_left->to_json());
-    object.add_key("right", m_right->to_json());
+void IndexExpression::write_json_attributes(JSONWriter &writer) const {
+    writer.key("base");
+    m_base->write_json(writer);
+    writer.key("index");
+    m_index->write_json(writer);
 }
 
 Call::Call(Token const &func, std::vector<Expression::ptr> args)
         : Expression{}, m_func{func}, m_args{std::move(args)}, 
           m_called{nullptr} {}
 
-void Call::add_json_attributes(JSONObject &object) const {
-    object.add_key("function", JSONString::Create(m_func.lexeme()));
-    object.add_key("args", Node::to_json_list(m_args));
+void Call::write_json_attributes(JSONWriter &writer) const {
+    writer.field("function", m_func.lexeme());
+    writer.key("args");
+    Node::write_json_list(writer, m_args);
 }
 
 Variable::Variable(Token const &ident)
-        : Expression{}, m_ident{ident} {}
+        : Expression{}, m_ident{ident}, m_symbol{nullptr} {}
 
-void Variable::add_json_attributes(JSONObject &object) const {
-    object.add_key("identifier", JSONString::Create(m_ident.lexeme()));
+void Variable::write_json_attributes(JSONWriter &writer) const {
+    writer.field("identifier", m_ident.lexeme());
 }
  
 Integer::Integer(Token const &literal)
         : Expression{}, m_literal{literal} {}
 
-void Integer::add_json_attributes(JSONObject &object) const {
+void Integer::write_json_attributes(JSONWriter &writer) const {
     int value = std::stoi(m_literal.lexeme());
-    object.add_key("value", JSONInteger::Create(value));
+    writer.field("value", value);
 }
 
 BooleanLiteral::BooleanLiteral(Token const &literal)
         : Expression{}, m_literal{literal} {}
 
-void BooleanLiteral::add_json_attributes(JSONObject &object) const {
-    object.add_key("value", JSONString::Create(m_literal.lexeme()));
+void BooleanLiteral::write_json_attributes(JSONWriter &writer) const {
+    writer.field("value", m_literal.lexeme());
 }
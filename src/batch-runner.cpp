@@ -0,0 +1,84 @@
+#include "batch-runner.hpp"
+#include "virtual-machine.hpp"
+#include "error.hpp"
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+BatchRunner::BatchRunner(Memory const &memory, ThreadPool &pool,
+                         Output::Format format)
+        : m_image{memory}, m_pool{pool}, m_format{format} {}
+
+std::vector<BatchRunner::Result> BatchRunner::run(
+        std::vector<std::vector<uint32_t>> const &inputs,
+        OpcodeHistogram *histogram) {
+    std::vector<Result> results(inputs.size());
+    std::mutex mutex;
+
+    m_pool.parallel_for(inputs.size(), [&](std::size_t i) {
+        Memory memory = m_image.clone();
+        Output output(results[i].output, m_format);
+
+        VirtualMachine vm(memory, output);
+        vm.inject(inputs[i]);
+
+        /* Counted apart, so that instances do not contend for it */
+        std::unique_ptr<OpcodeHistogram> counts;
+        if (histogram) {
+            counts = std::make_unique<OpcodeHistogram>();
+        }
+
+        try {
+            while (!vm.terminated()) {
+                if (counts) {
+                    vm.execute_step(*counts);
+                } else {
+                    vm.execute_step();
+                }
+            }
+        } catch (std::exception const &e) {
+            results[i].error = e.what();
+        }
+
+        output.flush();
+        results[i].steps = vm.steps();
+
+        if (counts) {
+            counts->end_run();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            histogram->merge(*counts);
+        }
+    });
+
+    return results;
+}
+
+std::vector<std::vector<uint32_t>> BatchRunner::read_inputs(
+        std::istream &stream) {
+    std::vector<std::vector<uint32_t>> inputs;
+
+    std::string line;
+    for (std::size_t n = 1; std::getline(stream, line); n++) {
+        std::size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+
+        std::istringstream values(line);
+        std::vector<uint32_t> &instance = inputs.emplace_back();
+
+        long long value;
+        while (values >> value) {
+            instance.push_back(static_cast<uint32_t>(value));
+        }
+
+        if (!values.eof()) {
+            std::stringstream ss;
+            ss << "read_inputs(): malformed input on line " << n;
+            throw FatalError(ss.str());
+        }
+    }
+
+    return inputs;
+}
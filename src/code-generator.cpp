@@ -4,67 +4,180 @@
 #include "error.hpp"
 #include <sstream>
 #include <iomanip>
+#include <unordered_set>
+
+CodeGenerator::CodeGenerator(ThreadPool &pool)
+        : m_pool{&pool}, m_data{}, m_callees{}, m_marks{false}, m_lines{},
+          m_curr_job{nullptr},
+          m_break_labels{}, m_continue_labels{}, m_scope{0}, m_fresh_id{1} {}
+
+CodeGenerator::CodeGenerator(int scope)
+        : m_pool{nullptr}, m_data{}, m_callees{}, m_marks{false},
+          m_lines{}, m_curr_job{nullptr},
+          m_break_labels{}, m_continue_labels{}, m_scope{scope}, 
+          m_fresh_id{1} {}
+
+std::vector<CodeGenerator::entry_type> CodeGenerator::generate(
+        Program &ast, line_map *lines) {
+    m_marks = lines != nullptr;
+
+    blob_map blobs;
+    generate_functions(ast.functions(), blobs);
+    Blob main = generate_main(ast);
+
+    /* Including those of functions that are not linked */
+    if (lines) {
+        lines->insert(lines->end(), main.lines.begin(), main.lines.end());
+        for (auto const &[def, blob] : blobs) {
+            lines->insert(lines->end(), blob.lines.begin(), blob.lines.end());
+        }
+    }
+
+    return link(main, blobs, ast.globals());
+}
 
-CodeGenerator::CodeGenerator()
-        : m_data{}, m_func_labels{}, m_jobs{}, m_curr_job{nullptr}, 
-          m_fresh_id{1}, m_scope{} {}
+CodeGenerator::Blob CodeGenerator::generate_main(Program &ast) {
+    /* Scope 0 is main, definition ids start at 1 */
+    CodeGenerator job(0);
+    job.m_marks = m_marks;
+    job.emit_main(ast);
 
-std::vector<CodeGenerator::entry_type> CodeGenerator::generate(Program &ast) {
-    m_data.clear();
+    return { std::move(job.m_data), std::move(job.m_callees),
+             std::move(job.m_lines) };
+}
 
-    m_scope.enter(ast.symbols());
+void CodeGenerator::generate_functions(
+        std::vector<FunctionDeclaration *> const &functions, blob_map &blobs) {
+    std::vector<Blob> generated(functions.size());
 
-    emit(Label(0));
+    m_pool->parallel_for(functions.size(), [&](std::size_t i) {
+        FunctionDefinition &def = functions[i]->definition();
+        CodeGenerator job(def.id());
+        job.m_marks = m_marks;
+        job.emit_function(def);
 
-    for (Statement::ptr const &stmt : ast.stmts()) {
-        if (stmt->kind() != NodeKind::FunctionDeclaration) {
-            stmt->accept(*this);
+        generated[i] = { std::move(job.m_data), std::move(job.m_callees),
+                         std::move(job.m_lines) };
+    });
+
+    for (std::size_t i = 0; i < functions.size(); i++) {
+        blobs[&functions[i]->definition()] = std::move(generated[i]);
+    }
+}
+
+std::vector<CodeGenerator::entry_type> CodeGenerator::link(
+        Blob const &main, blob_map const &blobs,
+        std::vector<GlobalVariableSymbol *> const &globals) {
+    std::vector<Blob const *> order = { &main };
+    std::unordered_set<FunctionDefinition *> emitted;
+
+    for (std::size_t k = 0; k < order.size(); k++) {
+        for (FunctionDefinition *callee : order[k]->callees) {
+            if (!emitted.insert(callee).second) {
+                continue;
+            }
+
+            auto iter = blobs.find(callee);
+            if (iter == blobs.end()) {
+                throw FatalError("link(): no code for function "
+                                 + std::to_string(callee->id()));
+            }
+            order.push_back(&iter->second);
         }
     }
 
-    emit(OpCode::Push, 0);
-    emit(OpCode::ECall, ECallFunction::Exit);
-    
-    while (!m_jobs.empty()) {
-        FunctionDefinition &def = *m_jobs.front();
-        m_curr_job = &def;
+    std::size_t size = 1;
+    for (Blob const *blob : order) {
+        size += blob->data.size();
+    }
+    for (GlobalVariableSymbol *global : globals) {
+        size += 1 + global->words();
+    }
+
+    std::vector<entry_type> data;
+    data.reserve(size);
+    for (Blob const *blob : order) {
+        data.insert(data.end(), blob->data.begin(), blob->data.end());
+    }
+
+    /* Nops assemble to zeroed words */
+    data.emplace_back(data_label());
+    for (GlobalVariableSymbol *global : globals) {
+        data.emplace_back(global_label(*global));
+        data.insert(data.end(), global->words(), Instruction(OpCode::Nop));
+    }
+
+    return data;
+}
 
-        emit(m_func_labels.find(&def)->second);
-        emit(OpCode::Enter, def.locals().size());
+Label CodeGenerator::entry_label(FunctionDefinition const &def) {
+    return Label(def.id(), 0);
+}
 
-        emit_function(*def.decl());
+CodeGenerator::name_map CodeGenerator::function_names(Program &ast) {
+    name_map names;
+    names[Label(0, 0).key()] = "main";
 
-        emit(OpCode::Push);
-        emit(OpCode::Ret, m_curr_job->type()->param_types().size());
+    for (FunctionDeclaration *decl : ast.functions()) {
+        FunctionDefinition &def = decl->definition();
 
-        m_jobs.pop();
+        std::stringstream ss;
+        ss << decl->func().lexeme() << "(";
+        for (std::size_t i = 0; i < def.type()->param_types().size(); i++) {
+            ss << (i ? "," : "") << *def.type()->param_types()[i];
+        }
+        ss << ")";
+
+        names[entry_label(def).key()] = ss.str();
     }
 
-    m_scope.leave(ast.symbols());
+    return names;
+}
 
-    return m_data;
+Label CodeGenerator::data_label() {
+    return Label(GlobalScope, 0);
 }
 
-void CodeGenerator::emit_function(FunctionDeclaration &decl) {
-    m_scope.enter(decl.symbols());
+Label CodeGenerator::global_label(GlobalVariableSymbol const &global) {
+    return Label(GlobalScope, global.id());
+}
 
-    int offset = 4 * (decl.params().size() + 1);
-    for (LocalVariableSymbol::unowned_ptr param : decl.definition().params()) {
-        param->set_offset(offset);
-        offset -= 4;
+void CodeGenerator::emit_main(Program &ast) {
+    emit(Label(m_scope, 0));
+
+    for (Statement::ptr const &stmt : ast.stmts()) {
+        if (stmt->kind() != NodeKind::FunctionDeclaration) {
+            emit_statement(*stmt);
+        }
     }
 
-    offset = -4;
-    for (LocalVariableSymbol::unowned_ptr local : decl.definition().locals()) {
-        local->set_offset(offset);
-        offset -= 4;
+    emit(OpCode::Push, 0);
+    emit(OpCode::ECall, ECallFunction::Exit);
+}
+
+void CodeGenerator::emit_function(FunctionDefinition &def) {
+    m_curr_job = &def;
+
+    emit(entry_label(def));
+    emit(OpCode::Enter, def.frame_size());
+
+    for (Statement::ptr &stmt : def.decl()->body()) {
+        emit_statement(*stmt);
     }
 
-    for (Statement::ptr &stmt : decl.body()) {
-        stmt->accept(*this);
+    emit(OpCode::Push);
+    emit(OpCode::Ret, def.type()->param_types().size());
+}
+
+void CodeGenerator::emit_statement(Statement &stmt) {
+    if (m_marks && stmt.kind() != NodeKind::ScopedBlockStatement
+            && stmt.kind() != NodeKind::FunctionDeclaration) {
+        Label label = fresh_label();
+        emit(label);
+        m_lines.emplace_back(label, stmt.pos().line());
     }
 
-    m_scope.leave(decl.symbols());
+    stmt.accept(*this);
 }
 
 Node &CodeGenerator::default_action(Node &node) {
@@ -86,25 +199,21 @@ Node &CodeGenerator::visit(FunctionDeclaration &decl) {
 }
 
 Node &CodeGenerator::visit(VariableDeclaration &decl) {
-    Symbol::unowned_ptr sym = m_scope.lookup(decl.ident());
-    LocalVariableSymbol::unowned_ptr local_sym
-            = dynamic_cast<LocalVariableSymbol::unowned_ptr>(sym);
+    if (!decl.value()) {
+        return decl;
+    }
 
     decl.value()->accept(*this);
-    emit(OpCode::StoreRel, local_sym->offset());
+    emit_access(decl.symbol(), OpCode::StoreRel, OpCode::StoreAbs);
 
     return decl;
 }
 
 Node &CodeGenerator::visit(ScopedBlockStatement &stmt) {
-    m_scope.enter(stmt.symbols());
-    
     for (Statement::ptr &substmt : stmt.body()) {
-        substmt->accept(*this);
+        emit_statement(*substmt);
     }
 
-    m_scope.leave(stmt.symbols());
-
     return stmt;
 }
 
@@ -117,15 +226,25 @@ Node &CodeGenerator::visit(ExpressionStatement &stmt) {
 
 Node &CodeGenerator::visit(AssignStatement &stmt) {
     if (stmt.target()->kind() == NodeKind::Variable) {
-        Variable &var = *dynamic_cast<Variable *>(stmt.target().get());
-
-        Symbol::unowned_ptr symbol = m_scope.lookup(var.ident());
-
-        LocalVariableSymbol::unowned_ptr var_symbol     
-                = dynamic_cast<LocalVariableSymbol *>(symbol);
+        Variable &var = static_cast<Variable &>(*stmt.target());
 
         stmt.value()->accept(*this);
-        emit(OpCode::StoreRel, var_symbol->offset());
+        emit_access(var.symbol(), OpCode::StoreRel, OpCode::StoreAbs);
+    } else if (stmt.target()->kind() == NodeKind::IndexExpression) {
+        IndexExpression &target
+                = static_cast<IndexExpression &>(*stmt.target());
+        VariableSymbol *array = word_array(target);
+
+        if (array) {
+            target.index()->accept(*this);
+            stmt.value()->accept(*this);
+            emit_access(*array, OpCode::StoreIdxRel, OpCode::StoreIdxAbs);
+        } else {
+            target.base()->accept(*this);
+            target.index()->accept(*this);
+            stmt.value()->accept(*this);
+            emit(store_opcode(target.width()));
+        }
     } else {
         throw std::runtime_error("not supported");
     }
@@ -144,14 +263,13 @@ Node &CodeGenerator::visit(IfElseStatement &stmt) {
     Label label_else = fresh_label();
     Label label_end = fresh_label();
     
-    stmt.condition()->accept(*this);
-    emit(OpCode::JumpIfNot, label_else);
+    emit_branch(*stmt.condition(), false, label_else);
 
-    stmt.then_stmt()->accept(*this);
+    emit_statement(*stmt.then_stmt());
     emit(OpCode::Jump, label_end);
 
     emit(label_else);
-    stmt.else_stmt()->accept(*this);
+    emit_statement(*stmt.else_stmt());
     emit(label_end);
 
     return stmt;
@@ -162,13 +280,12 @@ Node &CodeGenerator::visit(WhileStatement &stmt) {
     Label label_end = fresh_label();
 
     emit(label_loop);
-    stmt.condition()->accept(*this);
-    emit(OpCode::JumpIfNot, label_end);
+    emit_branch(*stmt.condition(), false, label_end);
 
     m_break_labels.push(label_end);
     m_continue_labels.push(label_loop);
 
-    stmt.loop_stmt()->accept(*this);
+    emit_statement(*stmt.loop_stmt());
     emit(OpCode::Jump, label_loop);
     emit(label_end);
 
@@ -199,10 +316,46 @@ Node &CodeGenerator::visit(ContinueStatement &stmt) {
 }
 
 Node &CodeGenerator::visit(UnaryExpression &expr) {
+    expr.operand()->accept(*this);
+
+    switch (expr.op().kind()) {
+        case TokenKind::Tilde:
+            emit(OpCode::INot);
+            break;
+
+        case TokenKind::Minus:
+            emit(OpCode::INeg);
+            break;
+
+        case TokenKind::Not:
+            emit(OpCode::Push, 0);
+            emit(OpCode::Equ);
+            break;
+
+        default:
+            throw FatalError("Unhandled operation: " + expr.op().lexeme());
+    }
+
     return expr;
 }
 
 Node &CodeGenerator::visit(BinaryExpression &expr) {
+    TokenKind op = expr.op().kind();
+
+    if (op == TokenKind::And || op == TokenKind::Or) {
+        Label label_false = fresh_label();
+        Label label_end = fresh_label();
+
+        emit_branch(expr, false, label_false);
+        emit(OpCode::Push, 1);
+        emit(OpCode::Jump, label_end);
+        emit(label_false);
+        emit(OpCode::Push, 0);
+        emit(label_end);
+
+        return expr;
+    }
+
     expr.left()->accept(*this);
     expr.right()->accept(*this);
 
@@ -227,6 +380,26 @@ Node &CodeGenerator::visit(BinaryExpression &expr) {
             emit(OpCode::IMod);
             break;
 
+        case TokenKind::Ampersand:
+            emit(OpCode::IAnd);
+            break;
+
+        case TokenKind::Pipe:
+            emit(OpCode::IOr);
+            break;
+
+        case TokenKind::Caret:
+            emit(OpCode::IXor);
+            break;
+
+        case TokenKind::ShiftLeft:
+            emit(OpCode::IShl);
+            break;
+
+        case TokenKind::ShiftRight:
+            emit(OpCode::IShr);
+            break;
+
         case TokenKind::DoubleEquals:
             emit(OpCode::Equ);
             break;
@@ -258,6 +431,21 @@ Node &CodeGenerator::visit(BinaryExpression &expr) {
     return expr;
 }
 
+Node &CodeGenerator::visit(IndexExpression &expr) {
+    VariableSymbol *array = word_array(expr);
+
+    if (array) {
+        expr.index()->accept(*this);
+        emit_access(*array, OpCode::LoadIdxRel, OpCode::LoadIdxAbs);
+    } else {
+        expr.base()->accept(*this);
+        expr.index()->accept(*this);
+        emit(load_opcode(expr.width()));
+    }
+
+    return expr;
+}
+
 Node &CodeGenerator::visit(Call &expr) {
     for (Expression::ptr &expr : expr.args()) {
         expr->accept(*this);
@@ -267,36 +455,20 @@ Node &CodeGenerator::visit(Call &expr) {
     if (def.is_ecall()) {
         emit(OpCode::ECall, def.ecall());
     } else {
-        auto iter = m_func_labels.find(&def);
-
-        Label label;
-        if (iter == m_func_labels.end()) {
-            label = fresh_label();
-            m_func_labels[&def] = label;
-            m_jobs.push(&def);
-        } else {
-            label = iter->second;
-        }
-
-        emit(OpCode::Call, label);
+        m_callees.push_back(&def);
+        emit(OpCode::Call, entry_label(def));
     }
 
     return expr;
 }
 
 Node &CodeGenerator::visit(Variable &expr) {
-    VariableSymbol::unowned_ptr var_symbol
-            = dynamic_cast<VariableSymbol *>(m_scope.lookup(expr.ident()));
-
-    LocalVariableSymbol::unowned_ptr var_local 
-            = dynamic_cast<LocalVariableSymbol *>(var_symbol);
-
-    if (var_local) {
-        emit(OpCode::LoadRel, var_local->offset());
-    } else {
-        throw FatalError("not implemented");
+    if (expr.symbol().is_array()) {
+        emit_access(expr.symbol(), OpCode::AddrRel, OpCode::AddrAbs);
+        return expr;
     }
 
+    emit_access(expr.symbol(), OpCode::LoadRel, OpCode::LoadAbs);
     return expr;
 }
 
@@ -310,8 +482,95 @@ Node &CodeGenerator::visit(BooleanLiteral &expr) {
     return expr;
 }
 
+void CodeGenerator::emit_branch(Expression &expr, bool when, Label target) {
+    if (expr.kind() == NodeKind::BinaryExpression) {
+        BinaryExpression &binary = static_cast<BinaryExpression &>(expr);
+        TokenKind op = binary.op().kind();
+
+        /* Jumping when a and b is true, or when a or b is false, needs
+           both operands, so the first one skips the second */
+        if ((op == TokenKind::And && !when) || (op == TokenKind::Or && when)) {
+            emit_branch(*binary.left(), when, target);
+            emit_branch(*binary.right(), when, target);
+            return;
+        } else if (op == TokenKind::And || op == TokenKind::Or) {
+            Label label_skip = fresh_label();
+
+            emit_branch(*binary.left(), !when, label_skip);
+            emit_branch(*binary.right(), when, target);
+            emit(label_skip);
+            return;
+        }
+    } else if (expr.kind() == NodeKind::UnaryExpression) {
+        UnaryExpression &unary = static_cast<UnaryExpression &>(expr);
+
+        if (unary.op().kind() == TokenKind::Not) {
+            emit_branch(*unary.operand(), !when, target);
+            return;
+        }
+    } else if (expr.kind() == NodeKind::BooleanLiteral) {
+        BooleanLiteral &literal = static_cast<BooleanLiteral &>(expr);
+
+        if ((literal.literal().kind() == TokenKind::True) == when) {
+            emit(OpCode::Jump, target);
+        }
+        return;
+    }
+
+    expr.accept(*this);
+    emit(when ? OpCode::JumpIf : OpCode::JumpIfNot, target);
+}
+
+void CodeGenerator::emit_access(VariableSymbol &symbol, OpCode rel,
+                                OpCode abs) {
+    if (symbol.is_global()) {
+        emit(abs, global_label(static_cast<GlobalVariableSymbol &>(symbol)));
+    } else {
+        emit(rel, static_cast<LocalVariableSymbol &>(symbol).offset());
+    }
+}
+
+VariableSymbol *CodeGenerator::word_array(IndexExpression &expr) {
+    if (expr.width() != 4 || expr.base()->kind() != NodeKind::Variable) {
+        return nullptr;
+    }
+
+    VariableSymbol &symbol = static_cast<Variable &>(*expr.base()).symbol();
+    if (!symbol.is_array()) {
+        return nullptr;
+    }
+
+    return &symbol;
+}
+
+OpCode CodeGenerator::load_opcode(int width) {
+    switch (width) {
+        case 1:
+            return OpCode::LoadByte;
+        case 2:
+            return OpCode::LoadHalf;
+        case 4:
+            return OpCode::LoadWord;
+        default:
+            throw FatalError("load_opcode(): unsupported width");
+    }
+}
+
+OpCode CodeGenerator::store_opcode(int width) {
+    switch (width) {
+        case 1:
+            return OpCode::StoreByte;
+        case 2:
+            return OpCode::StoreHalf;
+        case 4:
+            return OpCode::StoreWord;
+        default:
+            throw FatalError("store_opcode(): unsupported width");
+    }
+}
+
 Label CodeGenerator::fresh_label() {
-    Label label(m_fresh_id);
+    Label label(m_scope, m_fresh_id);
     m_fresh_id++;
     return label;
 }
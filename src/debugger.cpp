@@ -0,0 +1,556 @@
+#include "debugger.hpp"
+#include "error.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+Debugger::Debugger(VirtualMachine &vm, Program &program,
+                   Label::map_type const &labels,
+                   FunctionMap const &functions,
+                   CodeGenerator::line_map const &lines,
+                   std::string const &source)
+        : m_vm{vm}, m_memory{vm.memory()}, m_labels{labels},
+          m_functions{functions},
+          m_break{Instruction(OpCode::Break).assemble(labels)}, m_lines{},
+          m_line_addrs{}, m_source{}, m_definitions{}, m_locals{},
+          m_globals{}, m_breakpoints{}, m_next_id{1}, m_original{},
+          m_frame{0}, m_failed{false} {
+    m_vm.enable_breaks();
+
+    /* Statements without code share their address with the next one */
+    for (auto const &[label, line] : lines) {
+        auto iter = labels.find(label.key());
+        if (iter != labels.end()) {
+            m_lines[4 * iter->second] = line;
+        }
+    }
+
+    /* Entries stand for the line of the declaration, before the prologue */
+    for (FunctionDeclaration *decl : program.functions()) {
+        auto iter = labels.find(
+                CodeGenerator::entry_label(decl->definition()).key());
+        if (iter != labels.end()) {
+            m_lines.emplace(4 * iter->second, decl->pos().line());
+        }
+    }
+
+    for (auto const &[addr, line] : m_lines) {
+        m_line_addrs[line].push_back(addr);
+    }
+
+    std::ifstream file(source);
+    std::string text;
+    while (std::getline(file, text)) {
+        m_source.push_back(text);
+    }
+
+    for (FunctionDeclaration *decl : program.functions()) {
+        FunctionDefinition &def = decl->definition();
+        auto iter = labels.find(CodeGenerator::entry_label(def).key());
+        if (iter != labels.end()) {
+            m_definitions[iter->second] = &def;
+        }
+
+        std::vector<NamedVariable> &vars = m_locals[&def];
+        for (std::size_t i = 0; i < decl->params().size(); i++) {
+            Token const &ident = decl->params()[i]->ident();
+            vars.push_back({ ident.lexeme(), def.params()[i],
+                             ident.pos().line() });
+        }
+
+        for (Statement::ptr stmt : decl->body()) {
+            collect(*stmt, vars);
+        }
+    }
+
+    for (Statement::ptr stmt : program.stmts()) {
+        collect(*stmt, m_globals);
+    }
+}
+
+/* The variables declared by a statement and the blocks in it, but not by
+   nested functions */
+void Debugger::collect(Statement &stmt, std::vector<NamedVariable> &vars) {
+    switch (stmt.kind()) {
+        case NodeKind::VariableDeclaration: {
+            auto &decl = static_cast<VariableDeclaration &>(stmt);
+            vars.push_back({ decl.ident().lexeme(), &decl.symbol(),
+                             decl.pos().line() });
+            break;
+        }
+        case NodeKind::ScopedBlockStatement:
+            for (Statement::ptr substmt
+                    : static_cast<ScopedBlockStatement &>(stmt).body()) {
+                collect(*substmt, vars);
+            }
+            break;
+        case NodeKind::IfElseStatement:
+            collect(*static_cast<IfElseStatement &>(stmt).then_stmt(), vars);
+            collect(*static_cast<IfElseStatement &>(stmt).else_stmt(), vars);
+            break;
+        case NodeKind::WhileStatement:
+            collect(*static_cast<WhileStatement &>(stmt).loop_stmt(), vars);
+            break;
+        default:
+            break;
+    }
+}
+
+void Debugger::run() {
+    std::cerr << "Type help for the commands" << std::endl;
+    print_frame(0, frames().front());
+
+    std::string line, last;
+    while (!m_vm.terminated()) {
+        std::cerr << "(pix) " << std::flush;
+        if (!std::getline(std::cin, line)) {
+            std::cerr << std::endl;
+            return;
+        }
+
+        /* An empty line repeats the last command, e.g. to keep stepping */
+        if (line.empty()) {
+            line = last;
+        }
+        last = line;
+
+        try {
+            if (!execute(line)) {
+                return;
+            }
+        } catch (std::exception const &e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+}
+
+bool Debugger::execute(std::string const &line) {
+    std::istringstream words(line);
+    std::string command, arg;
+    words >> command >> arg;
+
+    if (command.empty()) {
+        return true;
+    } else if (command == "break" || command == "b") {
+        add_breakpoint(arg);
+    } else if (command == "delete" || command == "d") {
+        delete_breakpoint(std::stoi(arg));
+    } else if (command == "breakpoints" || command == "info") {
+        list_breakpoints();
+    } else if (command == "continue" || command == "c") {
+        go([this]() { resume(); });
+    } else if (command == "step" || command == "s") {
+        go([this]() { step_line(false); });
+    } else if (command == "next" || command == "n") {
+        go([this]() { step_line(true); });
+    } else if (command == "stepi" || command == "si") {
+        go([this]() { step_instruction(); });
+    } else if (command == "backtrace" || command == "bt") {
+        backtrace();
+    } else if (command == "frame" || command == "f") {
+        select_frame(arg.empty() ? m_frame : std::stoul(arg));
+    } else if (command == "print" || command == "p") {
+        print(arg);
+    } else if (command == "locals") {
+        print_locals();
+    } else if (command == "quit" || command == "q") {
+        return false;
+    } else if (command == "help" || command == "h") {
+        help();
+    } else {
+        std::cerr << "Unknown command " << command << ", type help for the "
+                  << "commands" << std::endl;
+    }
+
+    return true;
+}
+
+void Debugger::help() const {
+    std::cerr << "break (b) line|function  stop at a line or on entering "
+                 "a function\n"
+              << "delete (d) n             delete breakpoint n\n"
+              << "breakpoints (info)       list the breakpoints\n"
+              << "continue (c)             run until a breakpoint\n"
+              << "step (s)                 run to the next statement\n"
+              << "next (n)                 the same, over calls\n"
+              << "stepi (si)               run a single instruction\n"
+              << "backtrace (bt)           show the frames\n"
+              << "frame (f) n              select frame n\n"
+              << "print (p) variable       show a variable\n"
+              << "locals                   show the variables of the frame\n"
+              << "quit (q)                 stop debugging\n"
+              << "An empty line repeats the last command" << std::endl;
+}
+
+/* A line without code stands for the next one that has code. Functions
+   are given with their parameter types, or without them for all
+   overloads. */
+void Debugger::add_breakpoint(std::string const &location) {
+    if (location.empty()) {
+        throw FatalError("break: expected a line or a function");
+    }
+
+    Breakpoint breakpoint{ m_next_id, location, {} };
+
+    if (std::all_of(location.begin(), location.end(), ::isdigit)) {
+        auto iter = m_line_addrs.lower_bound(std::stoul(location));
+        if (iter == m_line_addrs.end()) {
+            throw FatalError("break: no code at or after line " + location);
+        }
+
+        breakpoint.location = "line " + std::to_string(iter->first);
+        breakpoint.addrs = iter->second;
+    } else {
+        for (FunctionMap::Function const &function : m_functions.functions()) {
+            if (function.name == location
+                    || function.name.substr(0, function.name.find('('))
+                            == location) {
+                breakpoint.addrs.push_back(4 * function.begin);
+            }
+        }
+
+        if (breakpoint.addrs.empty()) {
+            throw FatalError("break: no function " + location
+                             + " with code");
+        }
+    }
+
+    for (std::size_t addr : breakpoint.addrs) {
+        if (m_original.find(addr) == m_original.end()) {
+            m_original[addr] = m_memory.get_word(addr);
+            m_memory.set_word(m_break, addr);
+        }
+    }
+
+    std::cerr << "Breakpoint " << breakpoint.id << " at "
+              << breakpoint.location << std::endl;
+    m_breakpoints.push_back(std::move(breakpoint));
+    m_next_id++;
+}
+
+/* Addresses still used by other breakpoints stay patched */
+void Debugger::delete_breakpoint(int id) {
+    auto iter = std::find_if(m_breakpoints.begin(), m_breakpoints.end(),
+            [id](Breakpoint const &breakpoint) {
+                return breakpoint.id == id;
+            });
+    if (iter == m_breakpoints.end()) {
+        throw FatalError("delete: no breakpoint " + std::to_string(id));
+    }
+
+    std::vector<std::size_t> addrs = std::move(iter->addrs);
+    m_breakpoints.erase(iter);
+
+    for (std::size_t addr : addrs) {
+        bool used = std::any_of(m_breakpoints.begin(), m_breakpoints.end(),
+                [addr](Breakpoint const &breakpoint) {
+                    return std::count(breakpoint.addrs.begin(),
+                                      breakpoint.addrs.end(), addr) > 0;
+                });
+
+        auto original = m_original.find(addr);
+        if (!used && original != m_original.end()) {
+            m_memory.set_word(original->second, addr);
+            m_original.erase(original);
+        }
+    }
+}
+
+void Debugger::list_breakpoints() const {
+    if (m_breakpoints.empty()) {
+        std::cerr << "No breakpoints" << std::endl;
+    }
+
+    for (Breakpoint const &breakpoint : m_breakpoints) {
+        std::cerr << std::setw(4) << breakpoint.id << "  "
+                  << breakpoint.location << std::endl;
+    }
+}
+
+/* A program that threw cannot go on, but can still be looked at */
+template <typename F>
+void Debugger::go(F run) {
+    if (m_failed) {
+        throw FatalError("The program cannot go on after an error");
+    }
+
+    try {
+        run();
+    } catch (std::exception const &e) {
+        m_vm.output().flush();
+        m_failed = true;
+
+        std::cerr << "Error: " << e.what() << std::endl;
+        m_frame = 0;
+        print_frame(0, frames().front());
+        return;
+    }
+
+    m_vm.output().flush();
+
+    /* Not one of ours, so the code has been overwritten */
+    if (m_vm.stopped() && !m_original.count(m_vm.ip())) {
+        m_failed = true;
+        std::cerr << "Error: Break instruction at " << m_vm.ip()
+                  << " without a breakpoint" << std::endl;
+    } else if (m_vm.stopped()) {
+        m_vm.resume();
+
+        for (Breakpoint const &breakpoint : m_breakpoints) {
+            if (std::count(breakpoint.addrs.begin(), breakpoint.addrs.end(),
+                           m_vm.ip())) {
+                std::cerr << "Breakpoint " << breakpoint.id << ", ";
+            }
+        }
+    } else if (m_vm.terminated()) {
+        std::cerr << "The program exited after " << m_vm.steps()
+                  << " steps" << std::endl;
+        return;
+    }
+
+    m_frame = 0;
+    print_frame(0, frames().front());
+}
+
+void Debugger::resume() {
+    step_instruction();
+
+    while (!m_vm.terminated()) {
+        m_vm.execute_step();
+        m_vm.output().poll();
+    }
+}
+
+void Debugger::step_instruction() {
+    auto original = m_original.find(m_vm.ip());
+    if (original == m_original.end()) {
+        m_vm.execute_step();
+        return;
+    }
+
+    m_memory.set_word(original->second, original->first);
+    try {
+        m_vm.execute_step();
+    } catch (...) {
+        m_memory.set_word(m_break, original->first);
+        throw;
+    }
+    m_memory.set_word(m_break, original->first);
+}
+
+/* Frames are told apart by their bases. The frame stepped from is dropped
+   when it returns, as a later call may get the same base. */
+void Debugger::step_line(bool over) {
+    std::vector<std::size_t> bases;
+    for (Frame const &frame : frames()) {
+        bases.push_back(frame.base);
+    }
+
+    for (bool first = true; ; first = false) {
+        auto original = m_original.find(m_vm.ip());
+        uint32_t instruction = original != m_original.end()
+                ? original->second : m_memory.get_word(m_vm.ip());
+
+        if (Instruction::unpack_opcode(instruction) == OpCode::Ret
+                && !bases.empty() && bases.front() == m_vm.base()) {
+            bases.erase(bases.begin());
+        }
+
+        /* Breakpoints stop the stepping after the first instruction */
+        if (first) {
+            step_instruction();
+        } else {
+            m_vm.execute_step();
+            m_vm.output().poll();
+        }
+
+        if (m_vm.terminated()) {
+            return;
+        }
+
+        if (m_lines.count(m_vm.ip())
+                && (!over || std::count(bases.begin(), bases.end(),
+                                        m_vm.base()))) {
+            return;
+        }
+    }
+}
+
+/* Main runs without a frame, so the walk ends at the first base outside of
+   the stack */
+std::vector<Debugger::Frame> Debugger::frames() const {
+    std::vector<Frame> frames;
+    std::size_t ip = m_vm.ip();
+    std::size_t base = m_vm.base();
+
+    for (;;) {
+        FunctionMap::Function const *function = m_functions.find(ip);
+        auto iter = function ? m_definitions.find(function->begin)
+                             : m_definitions.end();
+        FunctionDefinition *def
+                = iter != m_definitions.end() ? iter->second : nullptr;
+        frames.push_back({ ip, base, def });
+
+        if (!def || base % 4 != 0 || base < m_memory.top()
+                || base + 8 > m_memory.size()) {
+            return frames;
+        }
+
+        /* The ip of a caller is that of its call */
+        ip = m_memory.get_word(base) - 4;
+        base = m_memory.get_word(base + 4);
+    }
+}
+
+void Debugger::backtrace() const {
+    std::vector<Frame> const frames = this->frames();
+    for (std::size_t i = 0; i < frames.size(); i++) {
+        print_frame(i, frames[i]);
+    }
+}
+
+void Debugger::select_frame(std::size_t i) {
+    std::vector<Frame> const frames = this->frames();
+    if (i >= frames.size()) {
+        throw FatalError("frame: no frame " + std::to_string(i));
+    }
+
+    m_frame = i;
+    print_frame(i, frames[i]);
+}
+
+void Debugger::print_frame(std::size_t i, Frame const &frame) const {
+    FunctionMap::Function const *function = m_functions.find(frame.ip);
+    std::size_t line = this->line(frame.ip);
+
+    std::cerr << "#" << i << "  " << (function ? function->name : "?");
+    if (line > 0) {
+        std::cerr << " at line " << line;
+    }
+    std::cerr << std::endl;
+
+    if (line > 0 && line <= m_source.size()) {
+        std::cerr << std::setw(6) << line << "  " << m_source[line - 1]
+                  << std::endl;
+    }
+}
+
+/* Locals of the selected frame come before globals of the same name */
+void Debugger::print(std::string const &name) const {
+    if (name.empty()) {
+        throw FatalError("print: expected a variable");
+    }
+
+    std::vector<Frame> const frames = this->frames();
+    Frame const &frame = frames.at(std::min(m_frame, frames.size() - 1));
+
+    for (std::vector<NamedVariable> const *vars
+            : { &variables(frame), &m_globals }) {
+        bool found = false;
+        for (NamedVariable const &var : *vars) {
+            if (var.name == name) {
+                print_variable(var, frame);
+                found = true;
+            }
+        }
+
+        if (found) {
+            return;
+        }
+    }
+
+    throw FatalError("print: no variable " + name);
+}
+
+void Debugger::print_locals() const {
+    std::vector<Frame> const frames = this->frames();
+    Frame const &frame = frames.at(std::min(m_frame, frames.size() - 1));
+    std::vector<NamedVariable> const &vars = variables(frame);
+
+    if (vars.empty()) {
+        std::cerr << "No locals" << std::endl;
+    }
+
+    for (NamedVariable const &var : vars) {
+        print_variable(var, frame);
+    }
+}
+
+/* Locals by their offset from the base of the frame, globals by their
+   label */
+void Debugger::print_variable(NamedVariable const &var,
+                              Frame const &frame) const {
+    std::size_t addr;
+
+    if (!var.symbol->is_global()) {
+        addr = frame.base
+                + static_cast<LocalVariableSymbol *>(var.symbol)->offset();
+    } else {
+        auto &global = static_cast<GlobalVariableSymbol &>(*var.symbol);
+        auto iter = m_labels.find(CodeGenerator::global_label(global).key());
+        if (iter == m_labels.end()) {
+            throw FatalError("print: " + var.name + " has no address");
+        }
+        addr = 4 * iter->second;
+    }
+
+    std::cerr << var.name << ": " << *var.symbol->type() << " = "
+              << format(var.symbol->type(), addr) << "  (declared at line "
+              << var.line << ")" << std::endl;
+}
+
+std::string Debugger::format(Type::unowned_ptr type, std::size_t addr) const {
+    std::ostringstream ss;
+
+    if (auto *array = dynamic_cast<ArrayType *>(type)) {
+        std::size_t shown = std::min(array->length(), MaxElements);
+
+        ss << "{";
+        for (std::size_t i = 0; i < shown; i++) {
+            ss << (i ? ", " : "")
+               << format(array->target(), addr + i * array->target()->size());
+        }
+        ss << (shown < array->length() ? ", ...}" : "}");
+    } else if (type == Type::BoolType()) {
+        ss << (m_memory.get_word(addr) ? "true" : "false");
+    } else if (type == Type::IntType()) {
+        ss << static_cast<int32_t>(m_memory.get_word(addr));
+    } else if (type == Type::ByteType()) {
+        ss << m_memory.get_byte(addr);
+    } else if (type == Type::HalfType()) {
+        ss << m_memory.get_half(addr);
+    } else if (dynamic_cast<PointerType *>(type)) {
+        ss << "0x" << std::hex << m_memory.get_word(addr);
+    } else {
+        ss << m_memory.get_word(addr);
+    }
+
+    return ss.str();
+}
+
+std::size_t Debugger::line(std::size_t ip) const {
+    FunctionMap::Function const *function = m_functions.find(ip);
+    auto iter = m_lines.upper_bound(ip);
+
+    if (!function || iter == m_lines.begin()
+            || std::prev(iter)->first < 4 * function->begin) {
+        return 0;
+    }
+
+    return std::prev(iter)->second;
+}
+
+std::vector<Debugger::NamedVariable> const &Debugger::variables(
+        Frame const &frame) const {
+    static std::vector<NamedVariable> const none;
+
+    /* Those of main are the globals */
+    if (!frame.def) {
+        return m_globals;
+    }
+
+    auto iter = m_locals.find(frame.def);
+    return iter != m_locals.end() ? iter->second : none;
+}
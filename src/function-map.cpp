@@ -0,0 +1,44 @@
+#include "function-map.hpp"
+#include <algorithm>
+
+FunctionMap::FunctionMap(Label::map_type const &labels,
+                         CodeGenerator::name_map const &names)
+        : m_functions{} {
+    for (auto const &[key, name] : names) {
+        auto iter = labels.find(key);
+
+        /* Functions never called are not linked */
+        if (iter != labels.end()) {
+            m_functions.push_back({ iter->second, 0, name });
+        }
+    }
+
+    std::sort(m_functions.begin(), m_functions.end(),
+            [](Function const &a, Function const &b) {
+                return a.begin < b.begin;
+            });
+
+    /* Each function ends where the next begins, and the last one where the
+       data does */
+    auto data = labels.find(CodeGenerator::data_label().key());
+    uint32_t end = data != labels.end() ? data->second : UINT32_MAX;
+
+    for (std::size_t i = m_functions.size(); i-- > 0; ) {
+        m_functions[i].end = end;
+        end = m_functions[i].begin;
+    }
+}
+
+FunctionMap::Function const *FunctionMap::find(std::size_t ip) const {
+    uint32_t word = ip / 4;
+    auto iter = std::upper_bound(m_functions.begin(), m_functions.end(), word,
+            [](uint32_t word, Function const &function) {
+                return word < function.begin;
+            });
+
+    if (iter == m_functions.begin() || word >= std::prev(iter)->end) {
+        return nullptr;
+    }
+
+    return &*std::prev(iter);
+}
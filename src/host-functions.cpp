@@ -0,0 +1,105 @@
+#include "host-functions.hpp"
+#include "virtual-machine.hpp"
+#include "options.hpp"
+#include "error.hpp"
+#include <sstream>
+
+HostFunctions::HostFunctions()
+        : m_functions{} {
+    add("", {}, Type::VoidType(), none, "<none>");
+    add("print", { Type::IntType() }, Type::VoidType(), print_int,
+        "print-int");
+    add("print", { Type::BoolType() }, Type::VoidType(), print_bool,
+        "print-bool");
+    add("input", { Type::IntType() }, Type::IntType(), input);
+    add("", {}, Type::VoidType(), exit, "exit", false);
+
+    /* Addresses are in bytes, rectangles are as wide as the framebuffer */
+    Type::unowned_ptr i = Type::IntType();
+    add("fill", { i, i, i }, Type::VoidType(), fill);
+    add("copy", { i, i, i }, Type::VoidType(), copy);
+    add("fill_rect", { i, i, i, i }, Type::VoidType(), fill_rect);
+    add("blit", { i, i, i, i }, Type::VoidType(), blit);
+}
+
+HostFunctions &HostFunctions::registry() {
+    static HostFunctions registry;
+    return registry;
+}
+
+ECallFunction HostFunctions::add(std::string name,
+                                 std::vector<Type::unowned_ptr> params,
+                                 Type::unowned_ptr ret,
+                                 callback_type callback,
+                                 std::string mnemonic,
+                                 bool pushes_result) {
+    if (params.size() > MaxParams) {
+        throw FatalError("add(): too many parameters for host function "
+                         + name);
+    }
+
+    if (mnemonic.empty()) {
+        mnemonic = name;
+    }
+
+    m_functions.push_back({ std::move(name), std::move(mnemonic),
+                            std::move(params), ret, callback,
+                            pushes_result });
+    return static_cast<ECallFunction>(m_functions.size() - 1);
+}
+
+HostFunctions::Function const &HostFunctions::get(ECallFunction ecall) const {
+    std::size_t index = static_cast<std::size_t>(ecall);
+
+    if (index >= m_functions.size()) {
+        std::stringstream ss;
+        ss << "Unknown host function: " << index;
+        throw FatalError(ss.str());
+    }
+
+    return m_functions[index];
+}
+
+uint32_t HostFunctions::none(VirtualMachine &, uint32_t const *) {
+    return 0;
+}
+
+uint32_t HostFunctions::print_int(VirtualMachine &vm, uint32_t const *args) {
+    vm.output().print_int(args[0]);
+    return 0;
+}
+
+uint32_t HostFunctions::print_bool(VirtualMachine &vm, uint32_t const *args) {
+    vm.output().print_bool(args[0]);
+    return 0;
+}
+
+uint32_t HostFunctions::input(VirtualMachine &vm, uint32_t const *args) {
+    return vm.input(args[0]);
+}
+
+uint32_t HostFunctions::exit(VirtualMachine &vm, uint32_t const *) {
+    vm.terminate();
+    return 0;
+}
+
+uint32_t HostFunctions::fill(VirtualMachine &vm, uint32_t const *args) {
+    vm.memory().fill(args[0], args[1], args[2]);
+    return 0;
+}
+
+uint32_t HostFunctions::copy(VirtualMachine &vm, uint32_t const *args) {
+    vm.memory().copy(args[0], args[1], args[2]);
+    return 0;
+}
+
+uint32_t HostFunctions::fill_rect(VirtualMachine &vm, uint32_t const *args) {
+    vm.memory().fill_rect(args[0], args[1], args[2], args[3],
+                          options.mem.width);
+    return 0;
+}
+
+uint32_t HostFunctions::blit(VirtualMachine &vm, uint32_t const *args) {
+    vm.memory().blit(args[0], args[1], args[2], args[3], options.mem.width);
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include "hot-reloader.hpp"
+#include "assembler.hpp"
+#include "error.hpp"
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+
+HotReloader::HotReloader(IncrementalCompiler &compiler, Memory &memory)
+        : m_compiler{compiler}, m_memory{memory}, m_inotify{-1}, m_name{},
+          m_entries{}, m_globals{}, m_code{}, m_end{0}, m_polls{0},
+          m_last_poll{std::chrono::steady_clock::now()} {
+    std::string const &fname = compiler.fname();
+    std::size_t slash = fname.rfind('/');
+
+    /* Editors often save by replacing the file, so the directory is watched
+       rather than the file itself */
+    std::string dir = slash == std::string::npos ? "."
+                                                 : fname.substr(0, slash + 1);
+    m_name = slash == std::string::npos ? fname : fname.substr(slash + 1);
+
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify < 0 || inotify_add_watch(m_inotify, dir.c_str(),
+                                           IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::string msg = std::strerror(errno);
+        if (m_inotify >= 0) {
+            close(m_inotify);
+        }
+        throw FatalError("Cannot watch " + fname + ": " + msg);
+    }
+}
+
+HotReloader::~HotReloader() {
+    close(m_inotify);
+}
+
+void HotReloader::load(std::vector<CodeGenerator::entry_type> const &data) {
+    Assembler assembler(data, m_memory);
+    assembler.assemble();
+
+    Label::map_type const &labels = assembler.labels();
+    for (auto const &[def, blob] : m_compiler.blobs()) {
+        uint64_t key = CodeGenerator::entry_label(*def).key();
+        auto iter = labels.find(key);
+
+        if (iter != labels.end()) {
+            m_entries[key] = iter->second;
+        }
+    }
+
+    m_globals.clear();
+    for (GlobalVariableSymbol *global : m_compiler.program().globals()) {
+        uint64_t key = CodeGenerator::global_label(*global).key();
+        m_globals[key] = labels.at(key);
+    }
+
+    /* The data segment is not code, whatever its words look like */
+    m_code = { { 0, labels.at(CodeGenerator::data_label().key()) } };
+    m_end = assembler.end();
+}
+
+void HotReloader::poll() {
+    if (++m_polls % PollSteps != 0) {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point now
+            = std::chrono::steady_clock::now();
+    if (now - m_last_poll < PollDelay) {
+        return;
+    }
+    m_last_poll = now;
+
+    if (written()) {
+        reload();
+    }
+}
+
+void HotReloader::reload() {
+    try {
+        m_compiler.compile(false);
+    } catch (std::exception const &e) {
+        std::cerr << e.what() << std::endl;
+        return;
+    }
+
+    CodeGenerator::blob_map const &blobs = m_compiler.blobs();
+
+    /* Changed functions that are loaded, and those they newly call */
+    std::vector<FunctionDefinition *> defs;
+    std::unordered_set<FunctionDefinition *> queued;
+
+    for (FunctionDefinition *def : m_compiler.changed()) {
+        if (m_entries.count(CodeGenerator::entry_label(*def).key())) {
+            defs.push_back(def);
+            queued.insert(def);
+        }
+    }
+
+    for (std::size_t k = 0; k < defs.size(); k++) {
+        for (FunctionDefinition *callee : blobs.at(defs[k]).callees) {
+            uint64_t key = CodeGenerator::entry_label(*callee).key();
+
+            if (!m_entries.count(key) && queued.insert(callee).second) {
+                defs.push_back(callee);
+            }
+        }
+    }
+
+    if (defs.empty()) {
+        return;
+    }
+
+    std::vector<CodeGenerator::entry_type> data;
+    Label::map_type labels = m_entries;
+    labels.insert(m_globals.begin(), m_globals.end());
+
+    for (FunctionDefinition *def : defs) {
+        std::vector<CodeGenerator::entry_type> const &code = blobs.at(def).data;
+
+        labels.erase(CodeGenerator::entry_label(*def).key());
+        data.insert(data.end(), code.begin(), code.end());
+    }
+
+    std::size_t size = std::count_if(data.begin(), data.end(),
+            [](CodeGenerator::entry_type const &entry) {
+                return std::holds_alternative<Instruction>(entry);
+            });
+
+    if (4 * (m_end + size) > m_memory.top()) {
+        std::cerr << m_compiler.fname() << ": no room left in memory for "
+                  << "the new code, not reloaded" << std::endl;
+        return;
+    }
+
+    Assembler assembler(data, m_memory, m_end, std::move(labels));
+    assembler.assemble();
+
+    std::unordered_map<uint32_t, uint32_t> moved;
+    for (FunctionDefinition *def : defs) {
+        uint64_t key = CodeGenerator::entry_label(*def).key();
+        uint32_t addr = assembler.labels().at(key);
+
+        auto iter = m_entries.find(key);
+        if (iter != m_entries.end()) {
+            moved[iter->second] = addr;
+        }
+        m_entries[key] = addr;
+    }
+
+    for (auto const &[begin, end] : m_code) {
+        for (std::size_t p = begin; p < end; p++) {
+            uint32_t assembled = m_memory.get_word(4 * p);
+
+            if (Instruction::unpack_opcode(assembled) != OpCode::Call) {
+                continue;
+            }
+
+            auto iter = moved.find(Instruction::unpack_data(assembled));
+            if (iter != moved.end()) {
+                Instruction call(OpCode::Call, iter->second);
+                m_memory.set_word(call.assemble({}), 4 * p);
+            }
+        }
+    }
+
+    m_code.emplace_back(m_end, assembler.end());
+    m_end = assembler.end();
+
+    std::cerr << m_compiler.fname() << ": reloaded " << defs.size()
+              << " function(s)" << std::endl;
+}
+
+bool HotReloader::written() {
+    alignas(inotify_event) char buffer[4096];
+    bool written = false;
+
+    ssize_t length;
+    while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0) {
+        for (char *p = buffer; p < buffer + length; ) {
+            inotify_event const *event = reinterpret_cast<inotify_event *>(p);
+
+            if (event->len > 0 && m_name == event->name) {
+                written = true;
+            }
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+
+    return written;
+}
@@ -0,0 +1,353 @@
+#include "incremental-compiler.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "symbol-resolver.hpp"
+#include "type-checker.hpp"
+#include "error.hpp"
+#include <algorithm>
+
+IncrementalCompiler::IncrementalCompiler(std::string fname, ThreadPool &pool)
+        : m_fname{std::move(fname)}, m_pool{pool}, m_program{},
+          m_main_fingerprint{}, m_chunks{}, m_main{}, m_blobs{}, m_changed{},
+          m_full{false} {}
+
+std::vector<CodeGenerator::entry_type> IncrementalCompiler::compile(
+        bool allow_full) {
+    Lexer lexer(m_fname);
+    std::vector<Token> tokens = lexer.lex();
+    Layout layout = split(tokens);
+
+    bool full = !m_program || layout.nested_main_functions
+            || layout.main != m_main_fingerprint;
+
+    /* Previous functions must all still be there, in the same order. New
+       ones may not reuse a name, as calls elsewhere could bind to them. */
+    std::vector<std::size_t> origins(layout.spans.size(), NoChunk);
+    std::vector<std::size_t> updated;
+    std::size_t next = 0;
+
+    for (std::size_t i = 0; !full && i < layout.spans.size(); i++) {
+        Span const &span = layout.spans[i];
+        Token const &name = tokens[span.begin + 1];
+
+        if (next < m_chunks.size()
+                && matches(m_chunks[next].header, tokens, 
+                           span.begin, span.body)) {
+            origins[i] = next;
+            if (!matches(m_chunks[next].body, tokens, span.body, span.end)) {
+                updated.push_back(i);
+            }
+            next++;
+        } else if (name.kind() == TokenKind::Identifier
+                   && !m_program->symbols().defines(name.id())) {
+            updated.push_back(i);
+        } else {
+            full = true;
+        }
+    }
+
+    if (next != m_chunks.size()) {
+        full = true;
+    }
+
+    if (full && !allow_full) {
+        throw FatalError(m_fname + ": only changes to function bodies can be "
+                         "applied without recompiling from scratch");
+    }
+
+    if (full) {
+        compile_all(std::move(tokens), layout);
+    } else {
+        compile_changed(tokens, layout, origins, updated);
+    }
+
+    m_full = full;
+    return CodeGenerator::link(m_main, m_blobs, m_program->globals());
+}
+
+IncrementalCompiler::Layout IncrementalCompiler::split(
+        std::vector<Token> const &tokens) {
+    Layout layout{ "", {}, false };
+    int depth = 0;
+
+    std::size_t i = 0;
+    while (i < tokens.size()) {
+        Token const &token = tokens[i];
+
+        if (token.kind() == TokenKind::Function && depth == 0) {
+            Span span{ i, i, i };
+
+            /* Parameters and return type contain no braces */
+            while (span.body < tokens.size()
+                   && tokens[span.body].kind() != TokenKind::BraceLeft
+                   && tokens[span.body].kind() != TokenKind::EndOfFile) {
+                span.body++;
+            }
+
+            int nesting = 0;
+            for (span.end = span.body; span.end < tokens.size(); span.end++) {
+                TokenKind kind = tokens[span.end].kind();
+
+                if (kind == TokenKind::EndOfFile) {
+                    break;
+                } else if (kind == TokenKind::BraceLeft) {
+                    nesting++;
+                } else if (kind == TokenKind::BraceRight && --nesting == 0) {
+                    span.end++;
+                    break;
+                }
+            }
+
+            layout.spans.push_back(span);
+            i = span.end;
+            continue;
+        }
+
+        if (token.kind() == TokenKind::Function) {
+            layout.nested_main_functions = true;
+        } else if (token.kind() == TokenKind::BraceLeft) {
+            depth++;
+        } else if (token.kind() == TokenKind::BraceRight) {
+            depth--;
+        }
+
+        append(layout.main, token);
+        i++;
+    }
+
+    return layout;
+}
+
+std::string IncrementalCompiler::fingerprint(std::vector<Token> const &tokens,
+                                             std::size_t begin,
+                                             std::size_t end) {
+    std::string result;
+    for (std::size_t i = begin; i < end; i++) {
+        append(result, tokens[i]);
+    }
+
+    return result;
+}
+
+void IncrementalCompiler::append(std::string &fingerprint,
+                                 Token const &token) {
+    fingerprint.push_back(static_cast<char>(token.kind()));
+    fingerprint.append(token.lexeme());
+    fingerprint.push_back('\0');
+}
+
+bool IncrementalCompiler::matches(std::string const &fingerprint,
+                                  std::vector<Token> const &tokens,
+                                  std::size_t begin, std::size_t end) {
+    std::size_t offset = 0;
+
+    for (std::size_t i = begin; i < end; i++) {
+        std::string const &lexeme = tokens[i].lexeme();
+
+        if (offset + lexeme.size() + 2 > fingerprint.size()
+                || fingerprint[offset] != static_cast<char>(tokens[i].kind())
+                || fingerprint.compare(offset + 1, lexeme.size(), lexeme) != 0
+                || fingerprint[offset + 1 + lexeme.size()] != '\0') {
+            return false;
+        }
+        offset += lexeme.size() + 2;
+    }
+
+    return offset == fingerprint.size();
+}
+
+void IncrementalCompiler::compile_all(std::vector<Token> tokens,
+                                      Layout const &layout) {
+    std::vector<std::string> headers;
+    std::vector<std::string> bodies;
+    for (Span const &span : layout.spans) {
+        headers.push_back(fingerprint(tokens, span.begin, span.body));
+        bodies.push_back(fingerprint(tokens, span.body, span.end));
+    }
+
+    Parser parser(std::move(tokens));
+    Program::ptr program = parser.parse();
+
+    SymbolResolver symbol_resolver;
+    program->accept(symbol_resolver);
+
+    TypeChecker type_checker(m_pool);
+    program->accept(type_checker);
+
+    CodeGenerator generator(m_pool);
+    CodeGenerator::blob_map blobs;
+    generator.generate_functions(program->functions(), blobs);
+    CodeGenerator::Blob main = generator.generate_main(*program);
+
+    /* Without functions nested in top-level statements, which always cause
+       a full compilation, the functions of each chunk are contiguous */
+    std::vector<FunctionDeclaration *> const &functions = program->functions();
+
+    std::vector<std::size_t> firsts;
+    for (Statement::ptr stmt : program->stmts()) {
+        if (stmt->kind() == NodeKind::FunctionDeclaration) {
+            std::size_t first = firsts.empty() ? 0 : firsts.back();
+            while (first < functions.size() && functions[first] != stmt) {
+                first++;
+            }
+            firsts.push_back(first);
+        }
+    }
+
+    if (firsts.size() != headers.size()) {
+        throw FatalError("compile(): top-level functions do not match "
+                         "their tokens");
+    }
+
+    std::vector<Chunk> chunks;
+    for (std::size_t k = 0; k < firsts.size(); k++) {
+        std::size_t last = k + 1 < firsts.size() ? firsts[k + 1] 
+                                                 : functions.size();
+
+        chunks.push_back({ std::move(headers[k]), std::move(bodies[k]),
+                           functions[firsts[k]], 
+                           { functions.begin() + firsts[k], 
+                             functions.begin() + last }, {} });
+    }
+
+    m_changed.clear();
+    for (FunctionDeclaration *decl : functions) {
+        m_changed.push_back(&decl->definition());
+    }
+
+    m_program = std::move(program);
+    m_main_fingerprint = layout.main;
+    m_chunks = std::move(chunks);
+    m_main = std::move(main);
+    m_blobs = std::move(blobs);
+}
+
+void IncrementalCompiler::compile_changed(
+        std::vector<Token> const &tokens, Layout const &layout,
+        std::vector<std::size_t> const &origins,
+        std::vector<std::size_t> const &updated) {
+    /* Dropped with the new functions if the compilation fails */
+    std::vector<Arena> arenas(updated.size());
+    std::vector<FunctionDeclaration *> decls;
+    for (std::size_t i : updated) {
+        Span const &span = layout.spans[i];
+
+        std::vector<Token> chunk_tokens(tokens.begin() + span.begin,
+                                        tokens.begin() + span.end);
+        chunk_tokens.push_back(tokens.back());
+
+        Parser parser(std::move(chunk_tokens));
+        decls.push_back(parser.parse_function(arenas[decls.size()]));
+    }
+
+    using Symbols = std::vector<LocalVariableSymbol::unowned_ptr>;
+    std::vector<FunctionDefinition *> defs;
+    std::vector<std::pair<Symbols, Symbols>> previous;
+
+    for (std::size_t i : updated) {
+        if (origins[i] == NoChunk) {
+            defs.push_back(nullptr);
+            previous.emplace_back();
+        } else {
+            FunctionDefinition &def = m_chunks[origins[i]].decl->definition();
+            defs.push_back(&def);
+            previous.emplace_back(def.params(), def.locals());
+        }
+    }
+
+    std::vector<std::vector<FunctionDeclaration *>> nested(updated.size());
+    std::vector<FunctionDeclaration *> generate;
+    CodeGenerator::blob_map blobs;
+
+    std::size_t resolved = 0;
+    try {
+        /* The header of a changed function is the same, so its new version
+           takes over the definition that callers were bound to */
+        for (; resolved < updated.size(); resolved++) {
+            SymbolResolver symbol_resolver;
+            nested[resolved] = symbol_resolver.resolve_function(
+                    *m_program, *decls[resolved], defs[resolved]);
+
+            generate.insert(generate.end(), nested[resolved].begin(),
+                            nested[resolved].end());
+        }
+
+        TypeChecker type_checker(m_pool);
+        type_checker.check_functions(generate);
+
+        CodeGenerator generator(m_pool);
+        generator.generate_functions(generate, blobs);
+    } catch (...) {
+        for (std::size_t k = 0; k < resolved; k++) {
+            if (defs[k]) {
+                FunctionDeclaration *decl = m_chunks[origins[updated[k]]].decl;
+                defs[k]->rebind(decl, previous[k].first, previous[k].second);
+            } else {
+                m_program->symbols().remove(decls[k]->func().id());
+            }
+        }
+        throw;
+    }
+
+    std::vector<Statement::ptr> &stmts = m_program->stmts();
+    std::vector<Chunk> chunks;
+    chunks.reserve(layout.spans.size());
+
+    std::size_t k = 0;
+    for (std::size_t i = 0; i < layout.spans.size(); i++) {
+        Span const &span = layout.spans[i];
+        bool is_updated = k < updated.size() && updated[k] == i;
+
+        if (origins[i] == NoChunk) {
+            auto at = chunks.empty() 
+                    ? stmts.begin()
+                    : std::find(stmts.begin(), stmts.end(), 
+                                chunks.back().decl) + 1;
+            stmts.insert(at, decls[k]);
+
+            chunks.push_back({ fingerprint(tokens, span.begin, span.body),
+                               fingerprint(tokens, span.body, span.end),
+                               decls[k], std::move(nested[k]),
+                               std::move(arenas[k]) });
+        } else {
+            chunks.push_back(std::move(m_chunks[origins[i]]));
+            Chunk &chunk = chunks.back();
+
+            if (is_updated) {
+                for (FunctionDeclaration *decl : chunk.functions) {
+                    m_blobs.erase(&decl->definition());
+                }
+
+                std::replace(stmts.begin(), stmts.end(),
+                             static_cast<Statement::ptr>(chunk.decl),
+                             static_cast<Statement::ptr>(decls[k]));
+
+                chunk.body = fingerprint(tokens, span.body, span.end);
+                chunk.decl = decls[k];
+                chunk.functions = std::move(nested[k]);
+                chunk.arena = std::move(arenas[k]);
+            }
+        }
+
+        if (is_updated) {
+            k++;
+        }
+    }
+
+    m_chunks = std::move(chunks);
+
+    std::vector<FunctionDeclaration *> &functions = m_program->functions();
+    functions.clear();
+    for (Chunk const &chunk : m_chunks) {
+        functions.insert(functions.end(), chunk.functions.begin(),
+                         chunk.functions.end());
+    }
+
+    m_changed.clear();
+    for (FunctionDeclaration *decl : generate) {
+        FunctionDefinition *def = &decl->definition();
+
+        m_changed.push_back(def);
+        m_blobs[def] = std::move(blobs[def]);
+    }
+}
@@ -1,10 +1,12 @@
 #include "instruction.hpp"
+#include "host-functions.hpp"
 #include "error.hpp"
+#include "utils.hpp"
 #include <unordered_map>
 #include <sstream>
 #include <iomanip>
 
-std::string const &to_string(OpCode instr) {
+static std::unordered_map<OpCode, std::string> const &opcode_names() {
     static std::unordered_map<OpCode, std::string> const map = {
         { OpCode::Nop, "nop" },
         { OpCode::ECall, "ecall" },
@@ -30,9 +32,35 @@ std::string const &to_string(OpCode instr) {
         { OpCode::IGT, "igt" },
         { OpCode::IGE, "ige" },
         { OpCode::Equ, "equ" },
-        { OpCode::Neq, "neq" }
+        { OpCode::Neq, "neq" },
+        { OpCode::LoadByte, "load-byte" },
+        { OpCode::LoadHalf, "load-half" },
+        { OpCode::LoadWord, "load-word" },
+        { OpCode::StoreByte, "store-byte" },
+        { OpCode::StoreHalf, "store-half" },
+        { OpCode::StoreWord, "store-word" },
+        { OpCode::LoadIdxRel, "load-idx-rel" },
+        { OpCode::StoreIdxRel, "store-idx-rel" },
+        { OpCode::AddrRel, "addr-rel" },
+        { OpCode::LoadIdxAbs, "load-idx-abs" },
+        { OpCode::StoreIdxAbs, "store-idx-abs" },
+        { OpCode::AddrAbs, "addr-abs" },
+        { OpCode::IAnd, "iand" },
+        { OpCode::IOr, "ior" },
+        { OpCode::IXor, "ixor" },
+        { OpCode::INot, "inot" },
+        { OpCode::IShl, "ishl" },
+        { OpCode::IShr, "ishr" },
+        { OpCode::INeg, "ineg" },
+        { OpCode::Break, "break" }
     };
 
+    return map;
+}
+
+std::string const &to_string(OpCode instr) {
+    std::unordered_map<OpCode, std::string> const &map = opcode_names();
+
     auto const &it = map.find(instr);
     if (it == map.end()) {
         std::stringstream ss;
@@ -43,27 +71,25 @@ std::string const &to_string(OpCode instr) {
     return it->second;
 }
 
+OpCode opcode_from_string(std::string const &str) {
+    static std::unordered_map<std::string, OpCode> const map
+            = inverse(opcode_names());
+
+    auto const &it = map.find(str);
+    if (it == map.end()) {
+        throw FatalError("Unknown opcode: " + str);
+    }
+
+    return it->second;
+}
+
 std::ostream &operator <<(std::ostream &stream, OpCode instr) {
     stream << to_string(instr);
     return stream;
 }
 
 std::string const &to_string(ECallFunction ecall) {
-    static std::unordered_map<ECallFunction, std::string> const map = {
-        { ECallFunction::None, "<none>" },
-        { ECallFunction::PrintInt, "print-int" },
-        { ECallFunction::PrintBool, "print-bool" },
-        { ECallFunction::Exit, "exit" }
-    };
-
-    auto const &it = map.find(ecall);
-    if (it == map.end()) {
-        std::stringstream ss;
-        ss << "Unmapped ecall: " << static_cast<int>(ecall);
-        throw FatalError(ss.str());
-    }
-
-    return it->second;
+    return HostFunctions::registry().get(ecall).mnemonic;
 }
 
 std::ostream &operator <<(std::ostream &stream, ECallFunction ecall) {
@@ -72,13 +98,16 @@ std::ostream &operator <<(std::ostream &stream, ECallFunction ecall) {
 }
 
 Label::Label()
-        : m_id{} {}
+        : m_scope{}, m_id{} {}
 
 Label::Label(int id)
-        : m_id{id} {}
+        : m_scope{}, m_id{id} {}
+
+Label::Label(int scope, int id)
+        : m_scope{scope}, m_id{id} {}
 
 std::ostream &operator <<(std::ostream &stream, Label const &label) {
-    stream << ".L" << label.m_id;
+    stream << ".L" << label.m_scope << "." << label.m_id;
     return stream;
 }
 
@@ -123,7 +152,7 @@ uint32_t Instruction::assemble_arg(Label::map_type const &labels) const {
 
     if (std::holds_alternative<Label>(arg)) {
         Label const &label = std::get<Label>(arg);
-        Label::map_type::const_iterator const &iter = labels.find(label.id());
+        Label::map_type::const_iterator const &iter = labels.find(label.key());
         
         if (iter == labels.end()) {
             std::stringstream ss;
@@ -0,0 +1,40 @@
+#include "interner.hpp"
+#include "error.hpp"
+#include <sstream>
+
+Interner::Interner()
+        : m_ids{{ "", 0 }}, m_strings{} {
+    m_strings.push_back(&m_ids.begin()->first);
+}
+
+Interner &Interner::instance() {
+    static Interner interner;
+    return interner;
+}
+
+Interner::id_type Interner::intern(std::string const &str) {
+    Interner &self = instance();
+
+    auto iter = self.m_ids.find(str);
+    if (iter != self.m_ids.end()) {
+        return iter->second;
+    }
+
+    id_type id = self.m_strings.size();
+    auto inserted = self.m_ids.emplace(str, id).first;
+    self.m_strings.push_back(&inserted->first);
+
+    return id;
+}
+
+std::string const &Interner::lookup(id_type id) {
+    Interner &self = instance();
+
+    if (id >= self.m_strings.size()) {
+        std::stringstream ss;
+        ss << "lookup(): unknown interned id: " << id;
+        throw FatalError(ss.str());
+    }
+
+    return *self.m_strings[id];
+}
@@ -3,109 +3,140 @@
 #include "options.hpp"
 #include <iomanip>
 
-JSON::JSON()
-        {} 
+JSONWriter::JSONWriter(std::ostream &stream)
+        : m_stream{stream}, m_levels{}, m_keyed{false} {}
 
-std::ostream &operator <<(std::ostream &stream, JSON const &json) {
-    json.write(stream, 0);
-    return stream;
+void JSONWriter::begin_object() {
+    begin_value();
+    m_stream << "{";
+    m_levels.push_back({ true, true });
 }
 
-JSONString::JSONString(std::string const &value)
-        : m_value{value} {}
+void JSONWriter::end_object() {
+    end(true);
+    m_stream << "}";
+}
 
-JSONString::ptr JSONString::Create(std::string const &value) {
-    return std::make_unique<JSONString>(value);
+void JSONWriter::begin_list() {
+    begin_value();
+    m_stream << "[";
+    m_levels.push_back({ false, true });
 }
 
-void JSONString::write(std::ostream &stream, std::size_t) const {
-    stream << "\"" << m_value << "\"";
+void JSONWriter::end_list() {
+    end(false);
+    m_stream << "]";
 }
 
-JSONInteger::JSONInteger(int value)
-        : m_value{value} {}
+void JSONWriter::key(std::string const &key) {
+    if (m_levels.empty() || !m_levels.back().object || m_keyed) {
+        throw FatalError("key(): not in an object: " + key);
+    }
 
-JSONInteger::ptr JSONInteger::Create(int value) {
-    return std::make_unique<JSONInteger>(value);
+    separate();
+    write_string(m_stream, key);
+    m_stream << ": ";
+    m_keyed = true;
 }
 
-void JSONInteger::write(std::ostream &stream, std::size_t) const {
-    stream << m_value;
+void JSONWriter::value(std::string const &value) {
+    begin_value();
+    write_string(m_stream, value);
 }
 
-JSONObject::JSONObject() 
-        : m_keys{} {}
-
-JSONObject::ptr JSONObject::Create() {
-    return std::make_unique<JSONObject>();
+void JSONWriter::value(char const *value) {
+    begin_value();
+    write_string(m_stream, value);
 }
 
-JSONObject &JSONObject::add_key(std::string const &key, JSON::ptr value) {
-    for (auto const &kv : m_keys) {
-        if (kv.first == key) {
-            throw FatalError("add_key(): duplicate key: " + key);
+void JSONWriter::write_string(std::ostream &stream, std::string const &value) {
+    stream << "\"";
+
+    for (char c : value) {
+        switch (c) {
+            case '"':
+                stream << "\\\"";
+                break;
+            case '\\':
+                stream << "\\\\";
+                break;
+            case '\b':
+                stream << "\\b";
+                break;
+            case '\f':
+                stream << "\\f";
+                break;
+            case '\n':
+                stream << "\\n";
+                break;
+            case '\r':
+                stream << "\\r";
+                break;
+            case '\t':
+                stream << "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    std::ios_base::fmtflags flags = stream.flags();
+                    stream << "\\u" << std::hex << std::setw(4)
+                           << std::setfill('0') << static_cast<int>(c)
+                           << std::setfill(' ');
+                    stream.flags(flags);
+                } else {
+                    stream << c;
+                }
         }
     }
 
-    m_keys.emplace_back(key, std::move(value));
-
-    return *this;
+    stream << "\"";
 }
 
-void JSONObject::write(std::ostream &stream, std::size_t depth) const {
-    if (m_keys.empty()) {
-        stream << "{ }";
+void JSONWriter::begin_value() {
+    /* The value of a key follows it on the same line */
+    if (m_keyed) {
+        m_keyed = false;
         return;
     }
-    
-    stream << "{";
-
-    bool first = true;
-    for (auto const &kv : m_keys) {
-        if (!first) {
-            stream << ",\n";
-        } else {
-            stream << "\n";
-        }
-        stream << std::setw(options.json.spacing * (depth + 1)) << "" 
-               << "\"" << kv.first << "\": ";
-        kv.second->write(stream, depth + 1);
-        first = false;
-    }
 
-    stream << "\n" << std::setw(options.json.spacing * depth) << "" << "}";
-}
+    if (m_levels.empty()) {
+        return;
+    }
 
-JSONList::JSONList()
-        : m_list{} {}
+    if (m_levels.back().object) {
+        throw FatalError("begin_value(): value without a key in an object");
+    }
 
-JSONList::ptr JSONList::Create() {
-    return std::make_unique<JSONList>();
+    separate();
 }
 
-void JSONList::add(JSON::ptr value) {
-    m_list.push_back(std::move(value));
+void JSONWriter::separate() {
+    Level &level = m_levels.back();
+
+    if (!level.empty) {
+        m_stream << ",";
+    }
+    m_stream << "\n";
+    indent(m_levels.size());
+    level.empty = false;
 }
 
-void JSONList::write(std::ostream &stream, std::size_t depth) const {
-    if (m_list.empty()) {
-        stream << "[ ]";
-        return;
+void JSONWriter::end(bool object) {
+    if (m_levels.empty() || m_levels.back().object != object || m_keyed) {
+        throw FatalError(object ? "end_object(): no object to end"
+                                : "end_list(): no list to end");
     }
-    
-    stream << "[";
-
-    bool first = true;
-    for (JSON::ptr const &value : m_list) {
-        if (!first) {
-            stream << ",\n";
-        } else {
-            stream << "\n";
-        }
-        stream << std::setw(options.json.spacing * (depth + 1)) << "";
-        value->write(stream, depth + 1);
-        first = false;
+
+    bool empty = m_levels.back().empty;
+    m_levels.pop_back();
+
+    if (empty) {
+        m_stream << " ";
+    } else {
+        m_stream << "\n";
+        indent(m_levels.size());
     }
-    
-    stream << "\n" << std::setw(options.json.spacing * depth) << "" << "]";
+}
+
+void JSONWriter::indent(std::size_t depth) {
+    m_stream << std::setw(options.json.spacing * depth) << "";
 }
@@ -52,7 +52,7 @@ std::vector<Token> Lexer::lex() {
     set_base();
     m_tokens.emplace_back(m_base_pos, TokenKind::EndOfFile);
 
-    return m_tokens;
+    return std::move(m_tokens);
 }
 
 std::string Lexer::read_file(std::string const &fname) {
@@ -135,10 +135,12 @@ void Lexer::lex_integer() {
     m_tokens.emplace_back(m_base_pos, TokenKind::Integer, lexeme());
 }
 
+/* Takes the longest operator, so that e.g. x*-2 is x * -2 */
 void Lexer::lex_operator() {
     do {
         advance();
-    } while (is_operator());
+    } while (is_operator()
+             && from_string(lexeme() + curr()) != TokenKind::None);
 
     TokenKind op = from_string(lexeme());
     if (op != TokenKind::None) {
@@ -11,8 +11,29 @@
 #include "instruction.hpp"
 #include "argparser.hpp"
 #include "options.hpp"
+#include "thread-pool.hpp"
+#include "incremental-compiler.hpp"
+#include "hot-reloader.hpp"
+#include "snapshot-writer.hpp"
+#include "batch-runner.hpp"
+#include "output.hpp"
+#include "stats.hpp"
+#include "opcode-histogram.hpp"
+#include "trace-recorder.hpp"
+#include "sample-profiler.hpp"
+#include "perf-map.hpp"
+#include "ast-serializer.hpp"
+#include "debugger.hpp"
+#include "utils.hpp"
+#include "error.hpp"
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <unistd.h>
 
 ArgParser setup_args() {
     ArgParser args;
@@ -21,6 +42,34 @@ ArgParser setup_args() {
                         ArgType::String);
     args.add_keyword(&options.no_exec, "no-exec",
                      ArgType::Flag);
+    args.add_keyword(&options.hot_reload, "hot-reload",
+                     ArgType::Flag);
+    args.add_keyword(&options.batch, "batch",
+                     ArgType::String);
+    args.add_keyword(&options.binary_output, "binary-output",
+                     ArgType::Flag);
+    args.add_keyword(&options.jobs, "jobs",
+                     ArgType::Integer, "0");
+    args.add_keyword(&options.stats, "stats",
+                     ArgType::Flag);
+    args.add_keyword(&options.stats_json, "stats-json",
+                     ArgType::Flag);
+    args.add_keyword(&options.opcode_histogram, "opcode-histogram",
+                     ArgType::String);
+    args.add_keyword(&options.trace, "trace",
+                     ArgType::String);
+    args.add_keyword(&options.sample_profile, "sample-profile",
+                     ArgType::String);
+    args.add_keyword(&options.sample_rate, "sample-rate",
+                     ArgType::Integer, "1000");
+    args.add_keyword(&options.perf_map, "perf-map",
+                     ArgType::Flag);
+    args.add_keyword(&options.perf_jitdump, "perf-jitdump",
+                     ArgType::Flag);
+    args.add_keyword(&options.ast_cache, "ast-cache",
+                     ArgType::String);
+    args.add_keyword(&options.debugger, "debug",
+                     ArgType::Flag);
 
     args.add_keyword(&options.debug.tokens, "debug-tokens",
                      ArgType::Flag);
@@ -46,67 +95,518 @@ ArgParser setup_args() {
     args.add_keyword(&options.json.spacing, "json-spacing",
                      ArgType::Integer, "2");
 
+    args.add_keyword(&options.snapshot.path, "snapshot",
+                     ArgType::String);
+    args.add_keyword(&options.snapshot.every, "snapshot-every",
+                     ArgType::Integer, "10000000");
+    args.add_keyword(&options.snapshot.resume, "resume",
+                     ArgType::String);
+
     return args;
 }
 
+Program::ptr analyze(ThreadPool &pool, Stats &stats) {
+    stats.start("lex");
+    Lexer lexer(options.filename);
+    std::vector<Token> tokens = lexer.lex();
+    stats.stop();
+    stats.count("tokens", tokens.size());
+
+    if (options.debug.tokens) {
+        std::cerr << "{" << std::endl;
+
+        for (Token const &token : tokens) {
+            std::cerr << std::setw(2) << "" << token << std::endl;
+        }
+
+        std::cerr << "}" << std::endl;
+    }
+
+    stats.start("parse");
+    Parser parser(tokens);
+    Program::ptr ast = parser.parse();
+    stats.stop();
+    stats.count("ast nodes", ast->arena().objects());
+
+    stats.start("resolve");
+    SymbolResolver symbol_resolver;
+    ast->accept(symbol_resolver);
+
+    stats.start("typecheck");
+    TypeChecker type_checker(pool);
+    ast->accept(type_checker);
+    stats.stop();
+
+    return ast;
+}
+
+/* FNV-1a of the source, seeded with the version of the AST format, so that
+   caches written by other versions are not used either */
+uint64_t source_key() {
+    std::ifstream file(options.filename, std::ios::binary);
+    if (!file) {
+        throw FatalError("Cannot open " + options.filename);
+    }
+
+    uint64_t key = UINT64_C(0xCBF29CE484222325) ^ AstSerializer::Version;
+    char c;
+    while (file.get(c)) {
+        key = (key ^ static_cast<uint8_t>(c)) * UINT64_C(0x100000001B3);
+    }
+
+    return key;
+}
+
+/* Null if the cache is missing, stale or unreadable, which just means that
+   the source is compiled again */
+Program::ptr load_ast_cache(uint64_t key) {
+    std::ifstream file(options.ast_cache, std::ios::binary);
+    if (!file) {
+        return nullptr;
+    }
+
+    try {
+        AstDeserializer deserializer(file);
+        return deserializer.source() == key ? deserializer.read() : nullptr;
+    } catch (std::exception const &) {
+        return nullptr;
+    }
+}
+
+void save_ast_cache(Program &ast, uint64_t key) {
+    std::ofstream file(options.ast_cache, std::ios::binary | std::ios::trunc);
+    AstSerializer(ast).write(file, key);
+
+    if (!file.flush()) {
+        throw FatalError("Cannot write " + options.ast_cache);
+    }
+}
+
+/* Leaves the program in ast, and with lines the statements marked for the
+   debugger */
+std::vector<CodeGenerator::entry_type> compile(
+        ThreadPool &pool, Stats &stats, CodeGenerator::name_map &functions,
+        Program::ptr &ast, CodeGenerator::line_map *lines = nullptr) {
+    uint64_t key = 0;
+
+    if (!options.ast_cache.empty()) {
+        key = source_key();
+
+        stats.start("load ast");
+        ast = load_ast_cache(key);
+        stats.stop();
+
+        if (ast) {
+            stats.count("ast nodes", ast->arena().objects());
+        }
+    }
+
+    if (!ast) {
+        ast = analyze(pool, stats);
+
+        if (!options.ast_cache.empty()) {
+            stats.start("save ast");
+            save_ast_cache(*ast, key);
+            stats.stop();
+        }
+    }
+
+    if (options.debug.ast) {
+        JSONWriter writer(std::cerr);
+        ast->write_json(writer);
+        std::cerr << std::endl;
+    }
+
+    stats.start("codegen");
+    std::vector<CodeGenerator::entry_type> data
+            = CodeGenerator(pool).generate(*ast, lines);
+    stats.stop();
+
+    functions = CodeGenerator::function_names(*ast);
+
+    return data;
+}
+
+/* Instructions of the code, and words of the data segment after it */
+std::pair<std::size_t, std::size_t> count_words(
+        std::vector<CodeGenerator::entry_type> const &data) {
+    uint64_t const data_key = CodeGenerator::data_label().key();
+    std::size_t code = 0;
+    std::size_t words = 0;
+    bool in_data = false;
+
+    for (CodeGenerator::entry_type const &entry : data) {
+        if (Label const *label = std::get_if<Label>(&entry)) {
+            in_data = in_data || label->key() == data_key;
+        } else {
+            (in_data ? words : code)++;
+        }
+    }
+
+    return { code, words };
+}
+
+Output::Format output_format() {
+    return options.binary_output ? Output::Format::Binary
+                                 : Output::Format::Text;
+}
+
+void write_stats(Stats const &stats) {
+    if (options.stats_json) {
+        JSONWriter writer(std::cerr);
+        stats.write_json(writer);
+        std::cerr << std::endl;
+    } else {
+        stats.write(std::cerr);
+    }
+}
+
+/* Adds to the histogram in the file, if there is one yet */
+std::unique_ptr<OpcodeHistogram> load_histogram() {
+    auto histogram = std::make_unique<OpcodeHistogram>();
+
+    std::ifstream file(options.opcode_histogram);
+    if (file) {
+        histogram->load(file);
+    }
+
+    return histogram;
+}
+
+void write_histogram(OpcodeHistogram const &histogram) {
+    std::ofstream file(options.opcode_histogram);
+    JSONWriter writer(file);
+    histogram.write_json(writer);
+
+    if (!(file << std::endl)) {
+        throw FatalError("Cannot write " + options.opcode_histogram);
+    }
+}
+
+int run_batch(Memory const &memory, ThreadPool &pool, Stats &stats,
+              OpcodeHistogram *histogram) {
+    std::ifstream file(options.batch);
+    if (!file) {
+        throw FatalError("Cannot open " + options.batch);
+    }
+
+    std::vector<std::vector<uint32_t>> inputs
+            = BatchRunner::read_inputs(file);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<BatchRunner::Result> results
+            = BatchRunner(memory, pool, output_format())
+                    .run(inputs, histogram);
+    std::chrono::duration<double> elapsed
+            = std::chrono::steady_clock::now() - start;
+
+    int status = 0;
+    uint64_t steps = 0;
+
+    for (std::size_t i = 0; i < results.size(); i++) {
+        std::string const &output = results[i].output;
+
+        /* Binary output of an instance is preceded by its number of values,
+           text output has the instance on every line */
+        if (options.binary_output) {
+            write_binary<uint32_t>(std::cout, output.size() / 4);
+            std::cout.write(output.data(), output.size());
+        } else {
+            std::istringstream lines(output);
+            std::string line;
+
+            while (std::getline(lines, line)) {
+                std::cout << "[" << i << "] " << line << "\n";
+            }
+        }
+
+        if (!results[i].error.empty()) {
+            std::cerr << "[" << i << "] " << results[i].error << std::endl;
+            status = 1;
+        }
+
+        steps += results[i].steps;
+    }
+    std::cout.flush();
+
+    stats.count("executed instructions", steps);
+
+    std::cerr << "batch: " << results.size() << " instances, " << steps
+              << " instructions in " << elapsed.count() << " s ("
+              << static_cast<uint64_t>(steps / elapsed.count())
+              << " instructions/s)" << std::endl;
+
+    return status;
+}
+
 int main(int argc, char *argv[]) {
     try {
         ArgParser args = setup_args();
         args.parse(argc, argv);
+        options.stats = options.stats || options.stats_json;
 
-        Lexer lexer(options.filename);
-        std::vector<Token> tokens = lexer.lex();
+        /* 0 is one job per core */
+        if (options.jobs < 0) {
+            throw FatalError("--jobs cannot be negative");
+        }
 
-        if (options.debug.tokens) {
-            std::cerr << "{" << std::endl;
+        ThreadPool pool(options.jobs);
+        Stats stats;
 
-            for (Token const &token : tokens) {
-                std::cerr << std::setw(2) << "" << token << std::endl;
-            }
+        /* Keeps the program around to compile edits against */
+        std::unique_ptr<IncrementalCompiler> compiler;
+        std::vector<CodeGenerator::entry_type> data;
+        CodeGenerator::name_map functions;
+        Program::ptr ast;
+        CodeGenerator::line_map lines;
 
-            std::cerr << "}" << std::endl;
+        bool const resume = !options.snapshot.resume.empty();
+
+        if (!options.batch.empty() && (resume || options.hot_reload)) {
+            throw FatalError("--batch cannot be combined with --resume or "
+                             "--hot-reload");
         }
 
-        Parser parser(tokens);
-        Program::ptr ast = parser.parse();
+        bool const trace = !options.trace.empty();
+        bool const histogram = !options.opcode_histogram.empty();
+        bool const profile = !options.sample_profile.empty();
+        bool const perf = options.perf_map || options.perf_jitdump;
+
+        /* Each of them runs the VM in its own way */
+        if (trace + histogram + profile + perf > 1) {
+            throw FatalError("Only one of --trace, --opcode-histogram, "
+                             "--sample-profile and --perf-* can be given");
+        }
 
-        SymbolResolver symbol_resolver;
-        ast->accept(symbol_resolver);
+        if (!options.batch.empty() && (trace || profile || perf)) {
+            throw FatalError("--batch cannot be combined with --trace, "
+                             "--sample-profile or --perf-*");
+        }
 
-        TypeChecker type_checker;
-        ast->accept(type_checker);
+        /* Functions are only known for code compiled once */
+        if ((profile || perf) && (resume || options.hot_reload)) {
+            throw FatalError("--sample-profile and --perf-* cannot be "
+                             "combined with --resume or --hot-reload");
+        }
 
-        if (options.debug.ast) {
-            std::cerr << *ast->to_json() << std::endl;
+        /* The incremental compiler keeps its own program */
+        if (!options.ast_cache.empty() && (resume || options.hot_reload)) {
+            throw FatalError("--ast-cache cannot be combined with --resume "
+                             "or --hot-reload");
         }
 
-        std::vector<CodeGenerator::entry_type> data 
-                = CodeGenerator().generate(*ast);
+        /* The debugger runs the VM itself, on code compiled once */
+        if (options.debugger
+                && (resume || options.hot_reload || !options.batch.empty()
+                    || trace || histogram || profile || perf
+                    || !options.snapshot.path.empty()
+                    || options.vis.visualize)) {
+            throw FatalError("--debug cannot be combined with --resume, "
+                             "--hot-reload, --batch, --trace, "
+                             "--opcode-histogram, --sample-profile, "
+                             "--perf-*, --snapshot or --visualize");
+        }
+
+        /* Snapshots hold their code, so there is nothing to compile */
+        if (resume) {
+            if (options.hot_reload) {
+                throw FatalError("--resume cannot be combined with "
+                                 "--hot-reload");
+            }
+        } else if (options.hot_reload) {
+            compiler = std::make_unique<IncrementalCompiler>(options.filename,
+                                                             pool);
+            stats.start("compile");
+            data = compiler->compile();
+            stats.stop();
+
+            if (options.debug.ast) {
+                JSONWriter writer(std::cerr);
+                compiler->program().write_json(writer);
+                std::cerr << std::endl;
+            }
+        } else {
+            data = compile(pool, stats, functions, ast,
+                           options.debugger ? &lines : nullptr);
+        }
+
+        auto [code_words, data_words] = count_words(data);
+        stats.count("emitted instructions", code_words);
+        stats.count("data words", data_words);
 
         if (options.debug.code) {
             std::cerr << data << std::endl;
         }
 
         if (options.no_exec) {
+            if (options.stats) {
+                write_stats(stats);
+            }
             return 0;
         }
 
         Memory memory(options.mem.width * options.mem.height);
-        Assembler(data, memory).assemble();
-        VirtualMachine vm(memory);
+
+        stats.start("assemble");
+        Label::map_type labels;
+        std::unique_ptr<HotReloader> reloader;
+        if (compiler) {
+            reloader = std::make_unique<HotReloader>(*compiler, memory);
+            reloader->load(data);
+        } else if (!resume) {
+            Assembler assembler(data, memory);
+            assembler.assemble();
+            labels = assembler.labels();
+        }
+        stats.stop();
+
+        std::unique_ptr<OpcodeHistogram> counts;
+        if (histogram) {
+            counts = load_histogram();
+        }
+
+        if (!options.batch.empty()) {
+            stats.start("execute");
+            int status = run_batch(memory, pool, stats, counts.get());
+            stats.stop();
+
+            if (counts) {
+                write_histogram(*counts);
+            }
+
+            if (options.stats) {
+                write_stats(stats);
+            }
+            return status;
+        }
+
+        Output output(STDOUT_FILENO, output_format());
+        VirtualMachine vm(memory, output);
+
+        if (resume) {
+            std::ifstream file(options.snapshot.resume, std::ios::binary);
+            if (!file) {
+                throw FatalError("Cannot open " + options.snapshot.resume);
+            }
+            vm.load(file);
+        }
+
+        std::unique_ptr<SnapshotWriter> snapshots;
+        if (!options.snapshot.path.empty()) {
+            if (options.snapshot.every <= 0) {
+                throw FatalError("--snapshot-every must be positive");
+            }
+            snapshots = std::make_unique<SnapshotWriter>(options.snapshot.path);
+        }
+
+        std::unique_ptr<TraceRecorder> recorder;
+        if (trace) {
+            recorder = std::make_unique<TraceRecorder>(options.trace);
+        }
+
+        FunctionMap function_map(labels, functions);
+
+        if (options.debugger) {
+            Debugger(vm, *ast, labels, function_map, lines,
+                     options.filename).run();
+            return 0;
+        }
+
+        std::unique_ptr<SampleProfiler> profiler;
+        if (profile) {
+            profiler = std::make_unique<SampleProfiler>(vm, function_map);
+        }
+
+        std::unique_ptr<PerfMap> perf_map;
+        if (perf) {
+            perf_map = std::make_unique<PerfMap>(vm, function_map,
+                                                 options.perf_map,
+                                                 options.perf_jitdump);
+        }
 
         Renderer renderer;
         if (options.vis.visualize) {
             renderer.init();
+            memory.track_dirty(options.mem.width);
         }
 
+        if (profiler) {
+            profiler->start(options.sample_rate);
+        }
+
+        stats.start("execute");
+        int steps = 0;
         while (!vm.terminated()) {
             if (renderer.process_events()) {
                 break;
             }
             
-            renderer.draw_frame(memory.raw());
-            vm.execute_step();
+            if (options.vis.visualize) {
+                renderer.draw_frame(memory.raw(), memory.take_dirty());
+            }
+            if (counts) {
+                vm.execute_step(*counts);
+            } else if (recorder) {
+                vm.execute_step(*recorder);
+            } else if (profiler) {
+                vm.execute_step(*profiler);
+            } else if (perf_map) {
+                perf_map->execute_step();
+            } else {
+                vm.execute_step();
+            }
+
+            output.poll();
+
+            if (reloader) {
+                reloader->poll();
+            }
+
+            if (snapshots && ++steps == options.snapshot.every) {
+                snapshots->write(vm);
+                steps = 0;
+            }
+        }
+
+        /* E.g. the window was closed, so that the run can be picked up */
+        if (snapshots && !vm.terminated()) {
+            snapshots->wait();
+            snapshots->write(vm);
+        }
+
+        stats.stop();
+        if (recorder && options.stats) {
+            stats.count("trace stalls", recorder->stalls());
+        }
+        recorder.reset();
+
+        if (counts) {
+            counts->end_run();
+            write_histogram(*counts);
+        }
+
+        if (profiler) {
+            profiler->stop();
+
+            std::ofstream file(options.sample_profile);
+            profiler->write(file);
+            if (!file) {
+                throw FatalError("Cannot write " + options.sample_profile);
+            }
+
+            if (options.stats) {
+                stats.count("samples", profiler->samples());
+            }
+        }
+
+        if (options.stats) {
+            double seconds = stats.phases().back().seconds;
+
+            output.flush();
+            stats.count("executed instructions", vm.steps());
+            stats.count("instructions/s",
+                        seconds > 0 ? vm.steps() / seconds : 0);
+            write_stats(stats);
         }
 
     } catch (std::exception const &e) {
@@ -1,28 +1,60 @@
 #include "memory.hpp"
 #include "error.hpp"
+#include "utils.hpp"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
 #include <sstream>
+#include <cstring>
 
 Memory::Memory(std::size_t size)
-        : m_mem{std::make_unique<char[]>(size)}, m_size{size}, m_top{0} {}
+        : m_mem{new char[size](), Release{size, false}},
+          m_size{size}, m_top{0}, m_row_size{0}, m_dirty_rows{} {}
 
-uint32_t Memory::get_word(std::size_t addr) {
-    if (addr % 4 != 0) {
-        std::stringstream ss;
-        ss << "get_word(): Unaligned access at " << addr;
-        throw FatalError(ss.str());
+Memory::Memory(char *mapped, std::size_t size)
+        : m_mem{mapped, Release{size, true}}, m_size{size}, m_top{0},
+          m_row_size{0}, m_dirty_rows{} {}
+
+void Memory::Release::operator ()(char *mem) const {
+    if (mapped) {
+        munmap(mem, size);
+    } else {
+        delete[] mem;
     }
+}
+
+uint32_t Memory::get_word(std::size_t addr) {
+    check_access("get_word", addr, 4);
     return *reinterpret_cast<uint32_t *>(&m_mem[addr]);
 }
 
 void Memory::set_word(uint32_t word, std::size_t addr) {
-    if (addr % 4 != 0) {
-        std::stringstream ss;
-        ss << "set_word(): Unaligned access to " << addr;
-        throw FatalError(ss.str());
-    }
+    check_access("set_word", addr, 4);
     *reinterpret_cast<uint32_t *>(&m_mem[addr]) = word;
+    mark_dirty(addr, addr + 4);
+}
+
+uint32_t Memory::get_half(std::size_t addr) {
+    check_access("get_half", addr, 2);
+    return *reinterpret_cast<uint16_t *>(&m_mem[addr]);
+}
+
+void Memory::set_half(uint32_t half, std::size_t addr) {
+    check_access("set_half", addr, 2);
+    *reinterpret_cast<uint16_t *>(&m_mem[addr]) = half;
+    mark_dirty(addr, addr + 2);
 }
 
+uint32_t Memory::get_byte(std::size_t addr) {
+    check_access("get_byte", addr, 1);
+    return static_cast<uint8_t>(m_mem[addr]);
+}
+
+void Memory::set_byte(uint32_t byte, std::size_t addr) {
+    check_access("set_byte", addr, 1);
+    m_mem[addr] = static_cast<char>(byte);
+    mark_dirty(addr, addr + 1);
+}
 
 uint32_t Memory::pop_word() {
     uint32_t word = get_word(m_top);
@@ -53,3 +85,203 @@ void Memory::push_n_words(std::size_t n) {
 void Memory::set_top(std::size_t top) {
     m_top = top;
 }
+
+void Memory::fill(std::size_t addr, uint8_t value, std::size_t size) {
+    check_range("fill", addr, size, 1, size);
+
+    std::memset(&m_mem[addr], value, size);
+    mark_dirty(addr, addr + size);
+}
+
+void Memory::copy(std::size_t dst, std::size_t src, std::size_t size) {
+    check_range("copy", dst, size, 1, size);
+    check_range("copy", src, size, 1, size);
+
+    std::memmove(&m_mem[dst], &m_mem[src], size);
+    mark_dirty(dst, dst + size);
+}
+
+void Memory::fill_rect(std::size_t addr, uint8_t value, std::size_t width,
+                       std::size_t height, std::size_t stride) {
+    check_range("fill_rect", addr, width, height, stride);
+
+    for (std::size_t y = 0; y < height; y++) {
+        std::memset(&m_mem[addr + y * stride], value, width);
+    }
+
+    if (height > 0) {
+        mark_dirty(addr, addr + (height - 1) * stride + width);
+    }
+}
+
+void Memory::blit(std::size_t dst, std::size_t src, std::size_t width,
+                  std::size_t height, std::size_t stride) {
+    check_range("blit", dst, width, height, stride);
+    check_range("blit", src, width, height, stride);
+
+    /* Rows are copied away from the overlap, like memmove does bytes */
+    for (std::size_t i = 0; i < height; i++) {
+        std::size_t y = dst > src ? height - 1 - i : i;
+        std::memmove(&m_mem[dst + y * stride], &m_mem[src + y * stride],
+                     width);
+    }
+
+    if (height > 0) {
+        mark_dirty(dst, dst + (height - 1) * stride + width);
+    }
+}
+
+void Memory::track_dirty(std::size_t row_size) {
+    if (row_size == 0) {
+        throw FatalError("track_dirty(): rows cannot be empty");
+    }
+
+    m_row_size = row_size;
+    m_dirty_rows.assign((m_size + row_size - 1) / row_size, true);
+}
+
+std::vector<std::pair<std::size_t, std::size_t>> Memory::take_dirty() {
+    std::vector<std::pair<std::size_t, std::size_t>> ranges;
+
+    for (std::size_t row = 0; row < m_dirty_rows.size(); row++) {
+        if (!m_dirty_rows[row]) {
+            continue;
+        }
+
+        std::size_t first = row;
+        for (; row < m_dirty_rows.size() && m_dirty_rows[row]; row++) {
+            m_dirty_rows[row] = false;
+        }
+
+        ranges.emplace_back(first * m_row_size,
+                            std::min(row * m_row_size, m_size));
+    }
+
+    return ranges;
+}
+
+void Memory::mark_rows(std::size_t begin, std::size_t end) {
+    for (std::size_t row = begin / m_row_size; row * m_row_size < end;
+         row++) {
+        m_dirty_rows[row] = true;
+    }
+}
+
+void Memory::access_error(char const *name, std::size_t addr,
+                          std::size_t size) const {
+    std::stringstream ss;
+    if (addr % size != 0) {
+        ss << name << "(): Unaligned access to " << addr;
+    } else {
+        ss << name << "(): Access to " << addr << " is out of bounds";
+    }
+    throw FatalError(ss.str());
+}
+
+void Memory::check_range(char const *name, std::size_t addr,
+                         std::size_t width, std::size_t height,
+                         std::size_t stride) const {
+    if (width == 0 || height == 0) {
+        return;
+    }
+
+    /* Computed in 64 bits, as the arguments come from 32 bit words */
+    uint64_t end = static_cast<uint64_t>(addr)
+            + static_cast<uint64_t>(height - 1) * stride + width;
+
+    if (width > stride || end > m_top) {
+        std::stringstream ss;
+        ss << name << "(): range of " << width << "x" << height
+           << " bytes at " << addr << " is out of bounds";
+        throw FatalError(ss.str());
+    }
+}
+
+void Memory::save(std::ostream &stream) const {
+    write_binary<uint64_t>(stream, m_size);
+    write_binary<uint64_t>(stream, m_top);
+
+    /* Records of a run of zeros followed by a run of other bytes */
+    std::size_t p = 0;
+    while (p < m_size) {
+        std::size_t begin = p;
+        while (begin < m_size && m_mem[begin] == 0) {
+            begin++;
+        }
+
+        std::size_t end = begin;
+        std::size_t zeros = 0;
+        while (end < m_size && zeros < MinZeroRun) {
+            zeros = m_mem[end] == 0 ? zeros + 1 : 0;
+            end++;
+        }
+        if (zeros == MinZeroRun) {
+            end -= zeros;
+        }
+
+        write_binary<uint32_t>(stream, begin - p);
+        write_binary<uint32_t>(stream, end - begin);
+        stream.write(&m_mem[begin], end - begin);
+
+        p = end;
+    }
+}
+
+void Memory::load(std::istream &stream) {
+    uint64_t size = read_binary<uint64_t>(stream);
+    if (size != m_size) {
+        std::stringstream ss;
+        ss << "load(): snapshot holds " << size << " bytes of memory, but "
+           << m_size << " are configured";
+        throw FatalError(ss.str());
+    }
+
+    m_top = read_binary<uint64_t>(stream);
+    std::memset(m_mem.get(), 0, m_size);
+    mark_dirty(0, m_size);
+
+    std::size_t p = 0;
+    while (p < m_size) {
+        p += read_binary<uint32_t>(stream);
+        uint32_t length = read_binary<uint32_t>(stream);
+
+        if (p + length > m_size || !stream.read(&m_mem[p], length)) {
+            throw FatalError("load(): malformed memory snapshot");
+        }
+        p += length;
+    }
+}
+
+MemoryImage::MemoryImage(Memory const &memory)
+        : m_fd{-1}, m_size{memory.size()} {
+    m_fd = memfd_create("pix-memory-image", MFD_CLOEXEC);
+
+    bool written = m_fd >= 0 && ftruncate(m_fd, m_size) == 0;
+    for (std::size_t p = 0; written && p < m_size; ) {
+        ssize_t n = pwrite(m_fd, memory.raw() + p, m_size - p, p);
+        written = n > 0;
+        p += written ? n : 0;
+    }
+
+    if (!written) {
+        std::string msg = std::strerror(errno);
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+        throw FatalError("MemoryImage(): " + msg);
+    }
+}
+
+MemoryImage::~MemoryImage() {
+    close(m_fd);
+}
+
+Memory MemoryImage::clone() const {
+    void *mapped = mmap(nullptr, m_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE, m_fd, 0);
+    if (mapped == MAP_FAILED) {
+        throw FatalError(std::string("clone(): ") + std::strerror(errno));
+    }
+
+    return Memory(static_cast<char *>(mapped), m_size);
+}
@@ -0,0 +1,215 @@
+#include "opcode-histogram.hpp"
+#include "error.hpp"
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+OpcodeHistogram::OpcodeHistogram()
+        : m_runs{0}, m_singles(Opcodes), m_pairs(Opcodes * Opcodes),
+          m_triples{}, m_window{0}, m_length{0} {}
+
+void OpcodeHistogram::end_run() {
+    m_runs++;
+    m_window = 0;
+    m_length = 0;
+}
+
+void OpcodeHistogram::merge(OpcodeHistogram const &other) {
+    m_runs += other.m_runs;
+
+    for (std::size_t i = 0; i < m_singles.size(); i++) {
+        m_singles[i] += other.m_singles[i];
+    }
+
+    for (std::size_t i = 0; i < m_pairs.size(); i++) {
+        m_pairs[i] += other.m_pairs[i];
+    }
+
+    for (auto const &[key, count] : other.m_triples) {
+        m_triples[key] += count;
+    }
+}
+
+/* The mnemonics of the n opcodes in key, separated by spaces */
+static std::string sequence_name(uint32_t key, int n) {
+    std::string name;
+
+    for (int i = n - 1; i >= 0; i--) {
+        name += to_string(static_cast<OpCode>((key >> 8 * i) & 0xFF));
+        if (i > 0) {
+            name += " ";
+        }
+    }
+
+    return name;
+}
+
+/* The nonzero counts, most frequent first */
+static void write_counts(JSONWriter &writer,
+                         std::vector<std::pair<uint32_t, uint64_t>> counts,
+                         int n) {
+    std::sort(counts.begin(), counts.end(),
+            [](auto const &a, auto const &b) {
+                return a.second != b.second ? a.second > b.second
+                                            : a.first < b.first;
+            });
+
+    writer.begin_object();
+    for (auto const &[key, count] : counts) {
+        writer.field(sequence_name(key, n), count);
+    }
+    writer.end_object();
+}
+
+void OpcodeHistogram::write_json(JSONWriter &writer) const {
+    std::vector<std::pair<uint32_t, uint64_t>> singles, pairs, triples;
+    uint64_t steps = 0;
+
+    for (std::size_t i = 0; i < m_singles.size(); i++) {
+        if (m_singles[i] > 0) {
+            singles.emplace_back(i, m_singles[i]);
+            steps += m_singles[i];
+        }
+    }
+
+    for (std::size_t i = 0; i < m_pairs.size(); i++) {
+        if (m_pairs[i] > 0) {
+            pairs.emplace_back(i, m_pairs[i]);
+        }
+    }
+
+    triples.assign(m_triples.begin(), m_triples.end());
+
+    writer.begin_object();
+    writer.field("runs", m_runs);
+    writer.field("steps", steps);
+    writer.key("opcodes");
+    write_counts(writer, std::move(singles), 1);
+    writer.key("pairs");
+    write_counts(writer, std::move(pairs), 2);
+    writer.key("triples");
+    write_counts(writer, std::move(triples), 3);
+    writer.end_object();
+}
+
+/* Reads just enough JSON for what write_json() writes: an object of
+   integers and of objects of integers */
+class HistogramReader {
+public:
+    HistogramReader(std::istream &stream)
+            : m_stream{stream} {}
+
+    void expect(char c) {
+        if (next() != c) {
+            std::stringstream ss;
+            ss << "load(): expected '" << c << "' in opcode histogram";
+            throw FatalError(ss.str());
+        }
+        m_stream.get();
+    }
+
+    /* Consumes c if it comes next */
+    bool accept(char c) {
+        if (next() != c) {
+            return false;
+        }
+        m_stream.get();
+        return true;
+    }
+
+    char next() {
+        m_stream >> std::ws;
+        return static_cast<char>(m_stream.peek());
+    }
+
+    std::string string() {
+        std::string value;
+
+        expect('"');
+        if (!std::getline(m_stream, value, '"')) {
+            throw FatalError("load(): unterminated string in opcode "
+                             "histogram");
+        }
+
+        return value;
+    }
+
+    uint64_t integer() {
+        uint64_t value;
+
+        m_stream >> std::ws;
+        if (!(m_stream >> value)) {
+            throw FatalError("load(): expected an integer in opcode "
+                             "histogram");
+        }
+
+        return value;
+    }
+
+    /* Calls f(key) for every key of an object, with the value next */
+    template <typename F>
+    void object(F f) {
+        expect('{');
+        if (accept('}')) {
+            return;
+        }
+
+        do {
+            std::string key = string();
+            expect(':');
+            f(key);
+        } while (accept(','));
+
+        expect('}');
+    }
+
+private:
+    std::istream &m_stream;
+};
+
+/* The key of a sequence of n mnemonics, as in sequence_name() */
+static uint32_t sequence_key(std::string const &name, int n) {
+    std::istringstream mnemonics(name);
+    std::string mnemonic;
+    uint32_t key = 0;
+    int length = 0;
+
+    while (mnemonics >> mnemonic) {
+        key = key << 8 | static_cast<uint8_t>(opcode_from_string(mnemonic));
+        length++;
+    }
+
+    if (length != n) {
+        throw FatalError("load(): malformed opcode sequence: " + name);
+    }
+
+    return key;
+}
+
+void OpcodeHistogram::load(std::istream &stream) {
+    HistogramReader reader(stream);
+
+    reader.object([&](std::string const &key) {
+        if (key == "runs") {
+            m_runs += reader.integer();
+        } else if (key == "steps") {
+            /* The sum of the opcodes */
+            reader.integer();
+        } else if (key == "opcodes") {
+            reader.object([&](std::string const &name) {
+                m_singles[sequence_key(name, 1)] += reader.integer();
+            });
+        } else if (key == "pairs") {
+            reader.object([&](std::string const &name) {
+                m_pairs[sequence_key(name, 2)] += reader.integer();
+            });
+        } else if (key == "triples") {
+            reader.object([&](std::string const &name) {
+                m_triples[sequence_key(name, 3)] += reader.integer();
+            });
+        } else {
+            throw FatalError("load(): unknown key in opcode histogram: "
+                             + key);
+        }
+    });
+}
@@ -0,0 +1,126 @@
+#include "output.hpp"
+#include "error.hpp"
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+Output::Output(int fd, Format format)
+        : m_fd{fd}, m_target{nullptr}, m_format{format},
+          m_buffer{new char[BufferSize]}, m_used{0}, m_polls{0},
+          m_last_flush{std::chrono::steady_clock::now()} {}
+
+Output::Output(std::string &target, Format format)
+        : m_fd{-1}, m_target{&target}, m_format{format},
+          m_buffer{new char[BufferSize]}, m_used{0}, m_polls{0},
+          m_last_flush{std::chrono::steady_clock::now()} {}
+
+Output::~Output() {
+    try {
+        flush();
+    } catch (std::exception const &) {
+        /* Nowhere left to report it */
+    }
+}
+
+void Output::print_int(uint32_t value) {
+    reserve(MaxValueSize);
+    char *out = m_buffer.get() + m_used;
+
+    if (m_format == Format::Binary) {
+        std::memcpy(out, &value, sizeof(value));
+        m_used += sizeof(value);
+        return;
+    }
+
+    bool negative = static_cast<int32_t>(value) < 0;
+    if (negative) {
+        value = 0 - value;
+    }
+
+    /* Digits are produced backwards, then moved behind the prompt */
+    char digits[11];
+    char *p = digits + sizeof(digits);
+    do {
+        *--p = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    if (negative) {
+        *--p = '-';
+    }
+
+    std::size_t length = digits + sizeof(digits) - p;
+
+    std::memcpy(out, ">> ", 3);
+    std::memcpy(out + 3, p, length);
+    out[3 + length] = '\n';
+    m_used += length + 4;
+}
+
+void Output::print_bool(bool value) {
+    if (m_format == Format::Binary) {
+        print_int(value);
+        return;
+    }
+
+    static constexpr char True[] = ">> True\n";
+    static constexpr char False[] = ">> False\n";
+
+    reserve(MaxValueSize);
+    if (value) {
+        std::memcpy(m_buffer.get() + m_used, True, sizeof(True) - 1);
+        m_used += sizeof(True) - 1;
+    } else {
+        std::memcpy(m_buffer.get() + m_used, False, sizeof(False) - 1);
+        m_used += sizeof(False) - 1;
+    }
+}
+
+void Output::flush() {
+    m_last_flush = std::chrono::steady_clock::now();
+
+    if (m_used == 0) {
+        return;
+    }
+
+    std::size_t used = m_used;
+    m_used = 0;
+    write(m_buffer.get(), used);
+}
+
+void Output::poll() {
+    if (++m_polls % PollSteps != 0 || m_used == 0) {
+        return;
+    }
+
+    if (std::chrono::steady_clock::now() - m_last_flush >= PollDelay) {
+        flush();
+    }
+}
+
+void Output::reserve(std::size_t size) {
+    if (m_used + size > BufferSize) {
+        flush();
+    }
+}
+
+void Output::write(char const *data, std::size_t size) {
+    if (m_target) {
+        m_target->append(data, size);
+        return;
+    }
+
+    while (size > 0) {
+        ssize_t written = ::write(m_fd, data, size);
+
+        if (written < 0 && errno == EINTR) {
+            continue;
+        } else if (written < 0) {
+            throw FatalError(std::string("Cannot write output: ")
+                             + std::strerror(errno));
+        }
+
+        data += written;
+        size -= written;
+    }
+}
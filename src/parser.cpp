@@ -8,20 +8,29 @@ ParserError::ParserError(TextPosition const &pos, std::string const &msg) {
 }
 
 Parser::Parser(std::vector<Token> tokens)
-        : m_tokens{tokens}, m_curr_idx{} {}
+        : m_tokens{std::move(tokens)}, m_curr_idx{}, m_arena{} {}
 
 Program::ptr Parser::parse() {
     std::vector<Statement::ptr> stmts;
 
     while (!accept(TokenKind::EndOfFile)) {
         Statement::ptr stmt = parse_statement();
-        stmts.push_back(std::move(stmt));
+        stmts.push_back(stmt);
     }
 
-    Program::ptr program = std::make_unique<Program>(std::move(stmts));
+    Program::ptr program = std::make_unique<Program>(std::move(m_arena), 
+                                                     std::move(stmts));
     return program;
 }
 
+FunctionDeclaration::ptr Parser::parse_function(Arena &arena) {
+    FunctionDeclaration::ptr decl = parse_function_declaration();
+    expect(TokenKind::EndOfFile);
+
+    arena = std::move(m_arena);
+    return decl;
+}
+
 void Parser::advance() {
     if (curr().kind() != TokenKind::EndOfFile) {
         m_curr_idx++;
@@ -107,13 +116,12 @@ Statement::ptr Parser::parse_statement() {
         Expression::ptr value = parse_expression();
         expect(TokenKind::Semicolon);
 
-        return std::make_unique<AssignStatement>(std::move(expr), 
-                                                 std::move(value));
+        return m_arena.create<AssignStatement>(expr, value);
     }
 
     expect(TokenKind::Semicolon);
 
-    return std::make_unique<ExpressionStatement>(std::move(expr));
+    return m_arena.create<ExpressionStatement>(expr);
 }
 
 FunctionDeclaration::ptr Parser::parse_function_declaration() {
@@ -128,14 +136,14 @@ FunctionDeclaration::ptr Parser::parse_function_declaration() {
         ret_type_annotation = parse_type_annotation();
     } else {
         Token token(curr().pos(), TokenKind::Identifier, "void");
-        ret_type_annotation = std::make_unique<NamedTypeAnnotation>(token);
+        ret_type_annotation = m_arena.create<NamedTypeAnnotation>(token);
     }
     
     std::vector<Statement::ptr> stmts = parse_body();
 
-    return std::make_unique<FunctionDeclaration>(func, std::move(params), 
-                                                 std::move(ret_type_annotation),
-                                                 std::move(stmts));
+    return m_arena.create<FunctionDeclaration>(func, std::move(params), 
+                                               ret_type_annotation,
+                                               std::move(stmts));
 }
 
 std::vector<ParameterDeclaration::ptr> Parser::parse_function_parameters() {
@@ -149,7 +157,7 @@ std::vector<ParameterDeclaration::ptr> Parser::parse_function_parameters() {
 
     while (true) {
         ParameterDeclaration::ptr param = parse_parameter_declaration();
-        params.push_back(std::move(param));
+        params.push_back(param);
 
         if (!accept(TokenKind::Comma)) {
             expect(TokenKind::ParenRight);
@@ -164,7 +172,7 @@ ParameterDeclaration::ptr Parser::parse_parameter_declaration() {
     expect(TokenKind::Colon);
     TypeAnnotation::ptr type = parse_type_annotation();
     
-    return std::make_unique<ParameterDeclaration>(ident, std::move(type));
+    return m_arena.create<ParameterDeclaration>(ident, type);
 }
 
 VariableDeclaration::ptr Parser::parse_variable_declaration() {
@@ -173,21 +181,38 @@ VariableDeclaration::ptr Parser::parse_variable_declaration() {
     expect(TokenKind::Colon);
     TypeAnnotation::ptr annotation = parse_type_annotation();
 
-    expect(TokenKind::Equals);
-    Expression::ptr value = parse_expression();
+    Expression::ptr value = nullptr;
+    if (accept(TokenKind::Equals)) {
+        value = parse_expression();
+    }
     expect(TokenKind::Semicolon);
 
-    return std::make_unique<VariableDeclaration>(ident, std::move(annotation), 
-                                                 std::move(value));
+    return m_arena.create<VariableDeclaration>(ident, annotation, value);
 }
 
 TypeAnnotation::ptr Parser::parse_type_annotation() {
+    Token const &star = curr();
+    if (accept(TokenKind::Times)) {
+        return m_arena.create<PointerTypeAnnotation>(star,
+                                                     parse_type_annotation());
+    }
+
     Token ident = expect(TokenKind::Identifier);
-    return std::make_unique<NamedTypeAnnotation>(ident);
+    TypeAnnotation::ptr annotation
+            = m_arena.create<NamedTypeAnnotation>(ident);
+
+    while (accept(TokenKind::BracketLeft)) {
+        Token length = expect(TokenKind::Integer);
+        expect(TokenKind::BracketRight);
+
+        annotation = m_arena.create<ArrayTypeAnnotation>(annotation, length);
+    }
+
+    return annotation;
 }
 
 Statement::ptr Parser::parse_scoped_body() {
-    return std::make_unique<ScopedBlockStatement>(parse_body());
+    return m_arena.create<ScopedBlockStatement>(parse_body());
 }
 
 std::vector<Statement::ptr> Parser::parse_body() {
@@ -211,7 +236,7 @@ Statement::ptr Parser::parse_return_statement() {
     Expression::ptr value = parse_expression();
     expect(TokenKind::Semicolon);
 
-    return std::make_unique<ReturnStatement>(std::move(value));
+    return m_arena.create<ReturnStatement>(value);
 }
 
 Statement::ptr Parser::parse_if_else_statement() {
@@ -230,12 +255,10 @@ Statement::ptr Parser::parse_if_else_statement() {
         }
     } else {
         std::vector<Statement::ptr> empty;
-        else_stmt = std::make_unique<ScopedBlockStatement>(std::move(empty));
+        else_stmt = m_arena.create<ScopedBlockStatement>(std::move(empty));
     }
 
-    return std::make_unique<IfElseStatement>(std::move(condition), 
-                                             std::move(then_stmt), 
-                                             std::move(else_stmt));
+    return m_arena.create<IfElseStatement>(condition, then_stmt, else_stmt);
 }
 
 Statement::ptr Parser::parse_while_statement() {
@@ -245,23 +268,57 @@ Statement::ptr Parser::parse_while_statement() {
 
     Statement::ptr stmt = parse_scoped_body();
 
-    return std::make_unique<WhileStatement>(std::move(condition), 
-                                            std::move(stmt));
+    return m_arena.create<WhileStatement>(condition, stmt);
 }
 
 Statement::ptr Parser::parse_break_statement() {
     Token token = expect(TokenKind::Break);
     expect(TokenKind::Semicolon);
-    return std::make_unique<BreakStatement>(token);
+    return m_arena.create<BreakStatement>(token);
 }
 
 Statement::ptr Parser::parse_continue_statement() {
     Token token = expect(TokenKind::Continue);
     expect(TokenKind::Semicolon);
-    return std::make_unique<ContinueStatement>(token);
+    return m_arena.create<ContinueStatement>(token);
 }
 
 Expression::ptr Parser::parse_expression() {
+    return parse_or();
+}
+
+Expression::ptr Parser::parse_or() {
+    Expression::ptr left = parse_and();
+
+    while (true) {
+        Token const &token = curr();
+        if (!accept(TokenKind::Or)) {
+            return left;
+        }
+
+        left = m_arena.create<BinaryExpression>(token, left, parse_and());
+    }
+}
+
+Expression::ptr Parser::parse_and() {
+    Expression::ptr left = parse_not();
+
+    while (true) {
+        Token const &token = curr();
+        if (!accept(TokenKind::And)) {
+            return left;
+        }
+
+        left = m_arena.create<BinaryExpression>(token, left, parse_not());
+    }
+}
+
+Expression::ptr Parser::parse_not() {
+    Token const &token = curr();
+    if (accept(TokenKind::Not)) {
+        return m_arena.create<UnaryExpression>(token, parse_not());
+    }
+
     return parse_equality_1();
 }
 
@@ -271,56 +328,133 @@ Expression::ptr Parser::parse_equality_1() {
     Token const &token = curr();
     if (accept(TokenKind::DoubleEquals) 
             || accept(TokenKind::NotEquals)) {
-        return std::make_unique<BinaryExpression>(token, std::move(left), 
-                                                  parse_equality_2());
+        return m_arena.create<BinaryExpression>(token, left, 
+                                                parse_equality_2());
     }
 
     return left;
 }
 
 Expression::ptr Parser::parse_equality_2() {
-    Expression::ptr left = parse_sum();
+    Expression::ptr left = parse_bitwise_or();
 
     Token const &token = curr();
     if (accept(TokenKind::LessThan) 
             || accept(TokenKind::LessEquals)
             || accept(TokenKind::GreaterThan) 
             || accept(TokenKind::GreaterEquals)) {
-        return std::make_unique<BinaryExpression>(token, std::move(left), 
-                                                  parse_sum());
+        return m_arena.create<BinaryExpression>(token, left,
+                                                parse_bitwise_or());
     }
 
     return left;
 }
 
+Expression::ptr Parser::parse_bitwise_or() {
+    Expression::ptr left = parse_bitwise_xor();
+
+    while (true) {
+        Token const &token = curr();
+        if (!accept(TokenKind::Pipe)) {
+            return left;
+        }
+
+        left = m_arena.create<BinaryExpression>(token, left,
+                                                parse_bitwise_xor());
+    }
+}
+
+Expression::ptr Parser::parse_bitwise_xor() {
+    Expression::ptr left = parse_bitwise_and();
+
+    while (true) {
+        Token const &token = curr();
+        if (!accept(TokenKind::Caret)) {
+            return left;
+        }
+
+        left = m_arena.create<BinaryExpression>(token, left,
+                                                parse_bitwise_and());
+    }
+}
+
+Expression::ptr Parser::parse_bitwise_and() {
+    Expression::ptr left = parse_shift();
+
+    while (true) {
+        Token const &token = curr();
+        if (!accept(TokenKind::Ampersand)) {
+            return left;
+        }
+
+        left = m_arena.create<BinaryExpression>(token, left, parse_shift());
+    }
+}
+
+Expression::ptr Parser::parse_shift() {
+    Expression::ptr left = parse_sum();
+
+    while (true) {
+        Token const &token = curr();
+        if (!accept(TokenKind::ShiftLeft) && !accept(TokenKind::ShiftRight)) {
+            return left;
+        }
+
+        left = m_arena.create<BinaryExpression>(token, left, parse_sum());
+    }
+}
+
 Expression::ptr Parser::parse_sum() {
     Expression::ptr left = parse_term();
 
-    Token token = curr();
-    while (accept(TokenKind::Plus)
-            || accept(TokenKind::Minus)) {
-        left = std::make_unique<BinaryExpression>(token, std::move(left), 
-                                                  parse_term());
-    }
+    while (true) {
+        Token const &token = curr();
+        if (!accept(TokenKind::Plus) && !accept(TokenKind::Minus)) {
+            return left;
+        }
 
-    return left;
+        left = m_arena.create<BinaryExpression>(token, left, parse_term());
+    }
 }
 
 Expression::ptr Parser::parse_term() {
-    Expression::ptr left = parse_value();
+    Expression::ptr left = parse_unary();
+
+    while (true) {
+        Token const &token = curr();
+        if (!accept(TokenKind::Times)
+                && !accept(TokenKind::FloorDiv)
+                && !accept(TokenKind::Modulo)) {
+            return left;
+        }
+
+        left = m_arena.create<BinaryExpression>(token, left, parse_unary());
+    }
+}
 
-    Token token = curr();
-    while (accept(TokenKind::Times)
-            || accept(TokenKind::FloorDiv)
-            || accept(TokenKind::Modulo)) {
-        left = std::make_unique<BinaryExpression>(token, std::move(left), 
-                                                  parse_value());
+Expression::ptr Parser::parse_unary() {
+    Token const &token = curr();
+    if (accept(TokenKind::Tilde) || accept(TokenKind::Minus)) {
+        return m_arena.create<UnaryExpression>(token, parse_unary());
     }
 
-    return left;
+    return parse_value();
 }
 
 Expression::ptr Parser::parse_value() {
+    Expression::ptr expr = parse_primary();
+
+    while (accept(TokenKind::BracketLeft)) {
+        Expression::ptr index = parse_expression();
+        expect(TokenKind::BracketRight);
+
+        expr = m_arena.create<IndexExpression>(expr, index);
+    }
+
+    return expr;
+}
+
+Expression::ptr Parser::parse_primary() {
     if (accept(TokenKind::ParenLeft)) {
         Expression::ptr expr = parse_expression();
         expect(TokenKind::ParenRight);
@@ -334,19 +468,19 @@ Expression::ptr Parser::parse_atom() {
     Token const &token = curr();
 
     if (accept(TokenKind::Integer)) {
-        return std::make_unique<Integer>(token);
+        return m_arena.create<Integer>(token);
     }
 
     if (accept(TokenKind::Identifier)) {
         if (matches(TokenKind::ParenLeft)) {
-            return std::make_unique<Call>(token, parse_call_args());
+            return m_arena.create<Call>(token, parse_call_args());
         }
 
-        return std::make_unique<Variable>(token);
+        return m_arena.create<Variable>(token);
     }
 
     if (accept(TokenKind::True) || accept(TokenKind::False)) {
-        return std::make_unique<BooleanLiteral>(token);
+        return m_arena.create<BooleanLiteral>(token);
     }
 
     std::stringstream ss;
@@ -365,7 +499,7 @@ std::vector<Expression::ptr> Parser::parse_call_args() {
 
     while (true) {
         Expression::ptr arg = parse_expression();
-        args.push_back(std::move(arg));
+        args.push_back(arg);
 
         if (!accept(TokenKind::Comma)) {
             expect(TokenKind::ParenRight);
@@ -0,0 +1,212 @@
+#include "perf-map.hpp"
+#include "error.hpp"
+#include "utils.hpp"
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+#if defined(__x86_64__)
+/* push rbp; mov rbp, rsp; call rsi; pop rbp; ret */
+static uint8_t const Stub[] = {
+    0x55, 0x48, 0x89, 0xE5, 0xFF, 0xD6, 0x5D, 0xC3
+};
+
+static constexpr uint32_t ElfMachine = EM_X86_64;
+
+/* stp x29, x30, [sp, #-16]!; mov x29, sp; blr x1; ldp x29, x30, [sp], #16;
+   ret */
+#elif defined(__aarch64__)
+static uint32_t const Stub[] = {
+    0xA9BF7BFD, 0x910003FD, 0xD63F0020, 0xA8C17BFD, 0xD65F03C0
+};
+
+static constexpr uint32_t ElfMachine = EM_AARCH64;
+#endif
+
+static std::string system_error(std::string const &call) {
+    return call + "(): " + std::strerror(errno);
+}
+
+PerfMap::PerfMap(VirtualMachine &vm, FunctionMap const &functions, bool map,
+                 bool jitdump)
+        : m_vm{vm}, m_functions{functions}, m_code{nullptr}, m_code_size{0},
+          m_begin{0}, m_end{0}, m_trampoline{nullptr}, m_error{},
+          m_jitdump{-1}, m_jitdump_marker{nullptr} {
+#if defined(__x86_64__) || defined(__aarch64__)
+    static_assert(sizeof(Stub) <= StubSize, "trampoline too large");
+
+    std::size_t stubs = functions.functions().size() + 1;
+    std::size_t page = sysconf(_SC_PAGESIZE);
+    m_code_size = (stubs * StubSize + page - 1) / page * page;
+
+    void *code = mmap(nullptr, m_code_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED) {
+        throw FatalError(system_error("mmap"));
+    }
+    m_code = static_cast<uint8_t *>(code);
+
+    for (std::size_t i = 0; i < stubs; i++) {
+        std::memcpy(stub(i), Stub, sizeof(Stub));
+    }
+
+    if (mprotect(m_code, m_code_size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(m_code, m_code_size);
+        throw FatalError(system_error("mprotect"));
+    }
+    __builtin___clear_cache(reinterpret_cast<char *>(m_code),
+                            reinterpret_cast<char *>(m_code + m_code_size));
+#else
+    throw FatalError("perf support needs x86-64 or AArch64");
+#endif
+
+    std::string pid = std::to_string(getpid());
+    if (map) {
+        write_map(std::string(P_tmpdir) + "/perf-" + pid + ".map");
+    }
+    if (jitdump) {
+        write_jitdump(std::string(P_tmpdir) + "/jit-" + pid + ".dump");
+    }
+
+    enter(m_vm.ip() / 4);
+}
+
+static uint64_t timestamp() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * UINT64_C(1000000000) + now.tv_nsec;
+}
+
+PerfMap::~PerfMap() {
+    if (m_jitdump >= 0) {
+        std::ostringstream close;
+        write_binary<uint32_t>(close, 3);
+        write_binary<uint32_t>(close, 16);
+        write_binary<uint64_t>(close, timestamp());
+
+        std::string const record = close.str();
+        if (write(m_jitdump, record.data(), record.size()) < 0) {
+            std::cerr << system_error("write") << std::endl;
+        }
+
+        munmap(m_jitdump_marker, sysconf(_SC_PAGESIZE));
+        ::close(m_jitdump);
+    }
+
+    if (m_code) {
+        munmap(m_code, m_code_size);
+    }
+}
+
+void PerfMap::enter(std::size_t word) {
+    std::vector<FunctionMap::Function> const &functions
+            = m_functions.functions();
+    FunctionMap::Function const *function = m_functions.find(4 * word);
+
+    if (function) {
+        m_begin = function->begin;
+        m_end = function->end;
+        m_trampoline = reinterpret_cast<Trampoline>(
+                stub(function - functions.data()));
+    } else {
+        m_begin = word;
+        m_end = word + 1;
+        m_trampoline = reinterpret_cast<Trampoline>(stub(functions.size()));
+    }
+}
+
+void PerfMap::step(PerfMap *perf) noexcept {
+    try {
+        perf->m_vm.execute_step();
+    } catch (...) {
+        perf->m_error = std::current_exception();
+    }
+}
+
+void PerfMap::rethrow() {
+    std::exception_ptr error = m_error;
+    m_error = nullptr;
+    std::rethrow_exception(error);
+}
+
+std::string const &PerfMap::name(std::size_t i) const {
+    static std::string const unknown = "?";
+
+    std::vector<FunctionMap::Function> const &functions
+            = m_functions.functions();
+    return i < functions.size() ? functions[i].name : unknown;
+}
+
+/* One line per trampoline: its address and size in hex, and its name */
+void PerfMap::write_map(std::string const &path) const {
+    std::ofstream file(path, std::ios::trunc);
+
+    for (std::size_t i = 0; i <= m_functions.functions().size(); i++) {
+        file << std::hex << reinterpret_cast<uintptr_t>(stub(i)) << " "
+             << StubSize << std::dec << " pix:" << name(i) << "\n";
+    }
+
+    if (!file.flush()) {
+        throw FatalError("Cannot write " + path);
+    }
+}
+
+/* A header and a code load record per trampoline, in the format of
+   tools/perf/Documentation/jitdump-specification.txt */
+void PerfMap::write_jitdump(std::string const &path) {
+    m_jitdump = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (m_jitdump < 0) {
+        throw FatalError("Cannot open " + path);
+    }
+
+    /* perf finds the file by this mapping of it */
+    m_jitdump_marker = mmap(nullptr, sysconf(_SC_PAGESIZE),
+                            PROT_READ | PROT_EXEC, MAP_PRIVATE, m_jitdump, 0);
+    if (m_jitdump_marker == MAP_FAILED) {
+        m_jitdump_marker = nullptr;
+        throw FatalError(system_error("mmap"));
+    }
+
+    std::ostringstream dump;
+    uint32_t const pid = getpid();
+
+    write_binary<uint32_t>(dump, 0x4A695444);
+    write_binary<uint32_t>(dump, 1);
+    write_binary<uint32_t>(dump, 40);
+    write_binary<uint32_t>(dump, ElfMachine);
+    write_binary<uint32_t>(dump, 0);
+    write_binary<uint32_t>(dump, pid);
+    write_binary<uint64_t>(dump, timestamp());
+    write_binary<uint64_t>(dump, 0);
+
+    for (std::size_t i = 0; i <= m_functions.functions().size(); i++) {
+        std::string const symbol = "pix:" + name(i);
+        uint64_t const addr = reinterpret_cast<uintptr_t>(stub(i));
+
+        write_binary<uint32_t>(dump, 0);
+        write_binary<uint32_t>(dump, 16 + 40 + symbol.size() + 1 + StubSize);
+        write_binary<uint64_t>(dump, timestamp());
+        write_binary<uint32_t>(dump, pid);
+        write_binary<uint32_t>(dump, syscall(SYS_gettid));
+        write_binary<uint64_t>(dump, addr);
+        write_binary<uint64_t>(dump, addr);
+        write_binary<uint64_t>(dump, StubSize);
+        write_binary<uint64_t>(dump, i);
+        dump.write(symbol.c_str(), symbol.size() + 1);
+        dump.write(reinterpret_cast<char const *>(stub(i)), StubSize);
+    }
+
+    std::string const records = dump.str();
+    if (write(m_jitdump, records.data(), records.size())
+            != static_cast<ssize_t>(records.size())) {
+        throw FatalError(system_error("write"));
+    }
+}
@@ -1,5 +1,6 @@
 #include "renderer.hpp"
 #include "options.hpp"
+#include <algorithm>
 
 Renderer::Renderer()
         : m_window{nullptr}, m_renderer{nullptr},
@@ -61,19 +62,34 @@ int Renderer::process_events() {
     return 0;
 }
 
-void Renderer::draw_frame(char const *data) {
+void Renderer::draw_frame(
+        char const *data,
+        std::vector<std::pair<std::size_t, std::size_t>> const &ranges) {
     if (!m_initialized) return;
 
-    for (int i = 0; i < options.mem.width * options.mem.height; i++) {
-        uint32_t r = ((data[i] >> 5) & 0x7) << 5;
-        uint32_t g = ((data[i] >> 3) & 0x3) << 6;
-        uint32_t b = ((data[i] >> 0) & 0x7) << 5;
+    std::size_t width = options.mem.width;
 
-        m_pixels[i] = (r << 16) | (g << 8) | b;
-    }
+    for (auto [begin, end] : ranges) {
+        end = std::min(end, width * options.mem.height);
+        if (begin >= end) {
+            continue;
+        }
 
-    SDL_UpdateTexture(m_texture, NULL, m_pixels.get(), 
-                      options.mem.width * sizeof(Uint32));
+        for (std::size_t i = begin; i < end; i++) {
+            uint32_t r = ((data[i] >> 5) & 0x7) << 5;
+            uint32_t g = ((data[i] >> 3) & 0x3) << 6;
+            uint32_t b = ((data[i] >> 0) & 0x7) << 5;
+
+            m_pixels[i] = (r << 16) | (g << 8) | b;
+        }
+
+        int first = begin / width;
+        int last = (end - 1) / width;
+        SDL_Rect rows = {0, first, options.mem.width, last - first + 1};
+
+        SDL_UpdateTexture(m_texture, &rows, &m_pixels[first * width],
+                          width * sizeof(Uint32));
+    }
 
     SDL_RenderClear(m_renderer);
     SDL_Rect dst = {0, 0, options.vis.width, options.vis.height};
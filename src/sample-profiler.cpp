@@ -0,0 +1,109 @@
+#include "sample-profiler.hpp"
+#include "error.hpp"
+#include <sys/time.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+volatile std::sig_atomic_t SampleProfiler::s_pending = 0;
+
+SampleProfiler::SampleProfiler(VirtualMachine &vm,
+                               FunctionMap const &functions)
+        : m_vm{vm}, m_functions{functions}, m_stacks{}, m_samples{0},
+          m_running{false}, m_previous{} {}
+
+SampleProfiler::~SampleProfiler() {
+    stop();
+}
+
+void SampleProfiler::start(int hz) {
+    if (hz <= 0 || hz > 1000000) {
+        throw FatalError("--sample-rate must be between 1 and 1000000");
+    }
+
+    struct sigaction action{};
+    action.sa_handler = handle;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    if (sigaction(SIGPROF, &action, &m_previous) != 0) {
+        throw FatalError(std::string("sigaction(): ")
+                         + std::strerror(errno));
+    }
+
+    itimerval timer{};
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = 1000000 / hz;
+    timer.it_value = timer.it_interval;
+
+    s_pending = 0;
+    m_running = true;
+
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        stop();
+        throw FatalError(std::string("setitimer(): ")
+                         + std::strerror(errno));
+    }
+}
+
+void SampleProfiler::stop() {
+    if (!m_running) {
+        return;
+    }
+
+    itimerval timer{};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    sigaction(SIGPROF, &m_previous, nullptr);
+
+    m_running = false;
+}
+
+void SampleProfiler::write(std::ostream &stream) const {
+    std::vector<std::pair<std::string, uint64_t>> stacks(m_stacks.begin(),
+                                                         m_stacks.end());
+    std::sort(stacks.begin(), stacks.end());
+
+    for (auto const &[stack, count] : stacks) {
+        stream << stack << " " << count << "\n";
+    }
+    stream.flush();
+}
+
+void SampleProfiler::sample(std::size_t ip) {
+    Memory &memory = m_vm.memory();
+    std::vector<std::string const *> frames = { &function_at(ip) };
+
+    /* Main runs without a frame, so the walk ends at the first base outside
+       of the stack */
+    std::size_t base = m_vm.base();
+    while (frames.size() < MaxDepth && base % 4 == 0
+            && base >= memory.top() && base + 8 <= memory.size()) {
+        std::size_t ret = memory.get_word(base);
+        frames.push_back(&function_at(ret - 4));
+        base = memory.get_word(base + 4);
+    }
+
+    std::string stack;
+    for (std::size_t i = frames.size(); i-- > 0; ) {
+        stack += *frames[i];
+        if (i > 0) {
+            stack += ";";
+        }
+    }
+
+    m_stacks[stack]++;
+    m_samples++;
+}
+
+std::string const &SampleProfiler::function_at(std::size_t ip) const {
+    static std::string const unknown = "?";
+
+    FunctionMap::Function const *function = m_functions.find(ip);
+    return function ? function->name : unknown;
+}
+
+void SampleProfiler::handle(int) {
+    s_pending = 1;
+}
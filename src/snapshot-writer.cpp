@@ -0,0 +1,70 @@
+#include "snapshot-writer.hpp"
+#include "error.hpp"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+SnapshotWriter::SnapshotWriter(std::string path)
+        : m_path{std::move(path)}, m_child{-1} {}
+
+SnapshotWriter::~SnapshotWriter() {
+    wait();
+}
+
+bool SnapshotWriter::write(VirtualMachine const &vm) {
+    if (!reap(false)) {
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw FatalError(std::string("fork(): ") + std::strerror(errno));
+    }
+
+    if (pid == 0) {
+        /* Leaves the parent's buffers and destructors alone */
+        int status = 1;
+        try {
+            std::string const temp = m_path + ".tmp";
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            vm.save(file);
+            file.close();
+
+            if (file && std::rename(temp.c_str(), m_path.c_str()) == 0) {
+                status = 0;
+            }
+        } catch (...) {}
+
+        _exit(status);
+    }
+
+    m_child = pid;
+    return true;
+}
+
+void SnapshotWriter::wait() {
+    reap(true);
+}
+
+bool SnapshotWriter::reap(bool block) {
+    if (m_child < 0) {
+        return true;
+    }
+
+    int status;
+    pid_t pid = waitpid(m_child, &status, block ? 0 : WNOHANG);
+    if (pid == 0) {
+        return false;
+    }
+
+    m_child = -1;
+    if (pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << "Failed to write snapshot " << m_path << std::endl;
+    }
+
+    return true;
+}
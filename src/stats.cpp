@@ -0,0 +1,207 @@
+#include "stats.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+#ifdef PIX_ALLOC_STATS
+
+/* Constant-initialized, so they count allocations of static constructors
+   too */
+static std::atomic<uint64_t> allocation_count{0};
+
+static std::atomic<uint64_t> allocation_bytes{0};
+
+static void *counted_alloc(std::size_t size, std::size_t align) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (size == 0) {
+        size = 1;
+    }
+
+    void *p = align <= alignof(std::max_align_t)
+            ? std::malloc(size)
+            : std::aligned_alloc(align, (size + align - 1) / align * align);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void *operator new(std::size_t size) {
+    return counted_alloc(size, alignof(std::max_align_t));
+}
+
+void *operator new[](std::size_t size) {
+    return counted_alloc(size, alignof(std::max_align_t));
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+    return counted_alloc(size, static_cast<std::size_t>(align));
+}
+
+void *operator new[](std::size_t size, std::align_val_t align) {
+    return counted_alloc(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+#endif
+
+Stats::Stats()
+        : m_phases{}, m_counts{}, m_created{Clock::now()}, m_started{},
+          m_allocations{0}, m_bytes{0}, m_running{false} {}
+
+void Stats::start(std::string const &name) {
+    stop();
+
+    m_phases.push_back({ name, 0, 0, 0 });
+    m_running = true;
+    m_allocations = allocations();
+    m_bytes = allocated_bytes();
+    m_started = Clock::now();
+}
+
+void Stats::stop() {
+    if (!m_running) {
+        return;
+    }
+
+    Phase &phase = m_phases.back();
+    phase.seconds = std::chrono::duration<double>(Clock::now() - m_started)
+            .count();
+    phase.allocations = allocations() - m_allocations;
+    phase.bytes = allocated_bytes() - m_bytes;
+    m_running = false;
+}
+
+void Stats::count(std::string const &name, uint64_t value) {
+    m_counts.emplace_back(name, value);
+}
+
+void Stats::write(std::ostream &stream) const {
+    double total = std::chrono::duration<double>(Clock::now() - m_created)
+            .count();
+
+    stream << "phase             time (ms)   allocations         bytes"
+           << std::endl;
+
+    std::ios_base::fmtflags flags = stream.flags();
+    stream << std::fixed << std::setprecision(3);
+
+    for (Phase const &phase : m_phases) {
+        stream << std::left << std::setw(12) << phase.name << std::right
+               << std::setw(16) << phase.seconds * 1000;
+
+        if (counts_allocations()) {
+            stream << std::setw(14) << phase.allocations
+                   << std::setw(14) << phase.bytes;
+        } else {
+            stream << std::setw(14) << "-" << std::setw(14) << "-";
+        }
+        stream << std::endl;
+    }
+
+    stream << std::left << std::setw(12) << "total" << std::right
+           << std::setw(16) << total * 1000 << std::endl;
+    stream.flags(flags);
+
+    for (auto const &[name, value] : m_counts) {
+        stream << name << ": " << value << std::endl;
+    }
+
+    if (!counts_allocations()) {
+        stream << "allocations are counted in builds made with STATS=1"
+               << std::endl;
+    }
+}
+
+void Stats::write_json(JSONWriter &writer) const {
+    double total = std::chrono::duration<double>(Clock::now() - m_created)
+            .count();
+
+    writer.begin_object();
+    writer.key("phases");
+    writer.begin_list();
+
+    for (Phase const &phase : m_phases) {
+        writer.begin_object();
+        writer.field("name", phase.name);
+        writer.field("ms", phase.seconds * 1000);
+
+        if (counts_allocations()) {
+            writer.field("allocations", phase.allocations);
+            writer.field("bytes", phase.bytes);
+        }
+        writer.end_object();
+    }
+
+    writer.end_list();
+    writer.field("total_ms", total * 1000);
+
+    writer.key("counts");
+    writer.begin_object();
+    for (auto const &[name, value] : m_counts) {
+        writer.field(name, value);
+    }
+    writer.end_object();
+
+    writer.end_object();
+}
+
+bool Stats::counts_allocations() {
+#ifdef PIX_ALLOC_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t Stats::allocations() {
+#ifdef PIX_ALLOC_STATS
+    return allocation_count.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+uint64_t Stats::allocated_bytes() {
+#ifdef PIX_ALLOC_STATS
+    return allocation_bytes.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
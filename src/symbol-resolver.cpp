@@ -6,20 +6,18 @@
 #include <memory>
 
 SymbolResolver::SymbolResolver()
-        : m_scope{} {}
+        : m_scope{}, m_declared{}, m_functions{nullptr}, m_globals{nullptr},
+          m_rebind{nullptr}, m_depth{0} {}
 
 Node &SymbolResolver::visit(Program &program) {
-    m_scope.enter(program.symbols());
+    m_functions = &program.functions();
+    m_functions->clear();
+    m_globals = &program.globals();
+    m_globals->clear();
 
-    declare_basic_function("print", Type::IntType(), Type::VoidType(), 
-                           ECallFunction::PrintInt);
-    declare_basic_function("print", Type::BoolType(), Type::VoidType(),
-                           ECallFunction::PrintBool);
+    m_scope.enter(program.symbols());
 
-    declare_basic_type("int", Type::IntType());
-    declare_basic_type("bool", Type::BoolType());
-    declare_basic_type("word", Type::WordType());
-    declare_basic_type("void", Type::VoidType());
+    declare_builtins(m_scope);
 
     /*for (Statement::ptr &stmt : program.stmts()) {
         // TODO ... forward declare classes here
@@ -33,9 +31,28 @@ Node &SymbolResolver::visit(Program &program) {
     return program;
 }
 
+std::vector<FunctionDeclaration *> SymbolResolver::resolve_function(
+        Program &program, FunctionDeclaration &decl, FunctionDefinition *def) {
+    std::vector<FunctionDeclaration *> functions;
+    m_functions = &functions;
+    m_globals = &program.globals();
+    m_rebind = def;
+
+    m_scope.enter(program.symbols());
+    decl.accept(*this);
+    m_scope.leave(program.symbols());
+
+    return functions;
+}
+
 Node &SymbolResolver::visit(ParameterDeclaration &decl) {
     decl.annotation()->accept(*this);
 
+    if (dynamic_cast<ArrayType *>(decl.annotation()->type())) {
+        throw ParserError(decl.pos(), "Arrays cannot be passed by value, "
+                                      "pass a pointer instead");
+    }
+
     LocalVariableSymbol::ptr var 
             = std::make_unique<LocalVariableSymbol>(decl.annotation()->type());
     m_declared.push_back(var.get());
@@ -45,7 +62,14 @@ Node &SymbolResolver::visit(ParameterDeclaration &decl) {
 }
 
 Node &SymbolResolver::visit(FunctionDeclaration &decl) {
+    m_functions->push_back(&decl);
+
+    FunctionDefinition *rebind = m_rebind;
+    m_rebind = nullptr;
+
+    decl.symbols().set_parent(&m_scope.current());
     m_scope.enter(decl.symbols());
+    m_depth++;
 
     decl.ret_type_annotation()->accept(*this);
     Type::unowned_ptr ret_type = decl.ret_type_annotation()->type();
@@ -64,10 +88,31 @@ Node &SymbolResolver::visit(FunctionDeclaration &decl) {
         stmt->accept(*this);
     }
 
+    m_depth--;
     m_scope.leave(decl.symbols());
 
     std::vector<LocalVariableSymbol::unowned_ptr> locals = m_declared;
 
+    int offset = 4 * (params.size() + 1);
+    for (LocalVariableSymbol::unowned_ptr param : params) {
+        param->set_offset(offset);
+        offset -= 4;
+    }
+
+    /* Locals take whole words, and the first element of an array is at
+       its lowest address */
+    offset = 0;
+    for (LocalVariableSymbol::unowned_ptr local : locals) {
+        offset -= 4 * local->words();
+        local->set_offset(offset);
+    }
+
+    if (rebind) {
+        rebind->rebind(&decl, params, locals);
+        decl.set_definition(*rebind);
+        return decl;
+    }
+
     FunctionType::ptr type = std::make_unique<FunctionType>(param_types, 
                                                             ret_type);
 
@@ -80,8 +125,20 @@ Node &SymbolResolver::visit(FunctionDeclaration &decl) {
 Node &SymbolResolver::visit(VariableDeclaration &decl) {
     decl.annotation()->accept(*this);
 
+    /* Everything outside of functions is global, blocks included */
+    if (m_depth == 0) {
+        GlobalVariableSymbol::ptr var = std::make_unique<GlobalVariableSymbol>(
+                decl.annotation()->type(), m_globals->size() + 1);
+        decl.set_symbol(*var);
+        m_globals->push_back(var.get());
+        m_scope.declare(decl.ident(), std::move(var));
+
+        return decl;
+    }
+
     LocalVariableSymbol::ptr var 
             = std::make_unique<LocalVariableSymbol>(decl.annotation()->type());
+    decl.set_symbol(*var);
     m_declared.push_back(var.get());
     m_scope.declare(decl.ident(), std::move(var));
 
@@ -102,7 +159,26 @@ Node &SymbolResolver::visit(NamedTypeAnnotation &anno) {
     return anno;
 }
 
+Node &SymbolResolver::visit(PointerTypeAnnotation &anno) {
+    anno.target()->accept(*this);
+    anno.set_type(PointerType::Get(anno.target()->type()));
+    return anno;
+}
+
+Node &SymbolResolver::visit(ArrayTypeAnnotation &anno) {
+    anno.target()->accept(*this);
+
+    int length = std::stoi(anno.length().lexeme());
+    if (length <= 0 || anno.target()->type()->size() == 0) {
+        throw ParserError(anno.pos(), "Arrays cannot be empty");
+    }
+
+    anno.set_type(ArrayType::Get(anno.target()->type(), length));
+    return anno;
+}
+
 Node &SymbolResolver::visit(ScopedBlockStatement &stmt) {
+    stmt.symbols().set_parent(&m_scope.current());
     m_scope.enter(stmt.symbols());
 
     for (Statement::ptr &substmt : stmt.body()) {
@@ -125,20 +201,38 @@ Node &SymbolResolver::visit(WhileStatement &stmt) {
     return stmt;
 }
 
-void SymbolResolver::declare_basic_type(std::string const &name, 
+void SymbolResolver::declare_builtins(SymbolScope &scope) {
+    std::vector<HostFunctions::Function> const &host_functions
+            = HostFunctions::registry().functions();
+    for (std::size_t i = 0; i < host_functions.size(); i++) {
+        if (!host_functions[i].name.empty()) {
+            declare_basic_function(scope, host_functions[i],
+                                   static_cast<ECallFunction>(i));
+        }
+    }
+
+    declare_basic_type(scope, "int", Type::IntType());
+    declare_basic_type(scope, "bool", Type::BoolType());
+    declare_basic_type(scope, "word", Type::WordType());
+    declare_basic_type(scope, "void", Type::VoidType());
+    declare_basic_type(scope, "byte", Type::ByteType());
+    declare_basic_type(scope, "half", Type::HalfType());
+}
+
+void SymbolResolver::declare_basic_type(SymbolScope &scope,
+                                        std::string const &name,
                                         Type::unowned_ptr type) {
     BasicTypeSymbol::ptr symbol =
             std::make_unique<BasicTypeSymbol>(type);
-    m_scope.declare(name, std::move(symbol));
+    scope.declare(name, std::move(symbol));
 }
 
-void SymbolResolver::declare_basic_function(std::string const &name, 
-                                            Type::unowned_ptr param_type, 
-                                            Type::unowned_ptr ret_type, 
-                                            ECallFunction ecall) {
-    std::vector<Type::unowned_ptr> params = { param_type };
-    FunctionType::ptr type = std::make_unique<FunctionType>(params, ret_type);
+void SymbolResolver::declare_basic_function(
+        SymbolScope &scope, HostFunctions::Function const &function,
+        ECallFunction ecall) {
+    FunctionType::ptr type = std::make_unique<FunctionType>(function.params,
+                                                            function.ret);
 
     FunctionDefinition def(std::move(type), ecall);
-    m_scope.declare_function(name, std::move(def));
+    scope.declare_function(function.name, std::move(def));
 }
@@ -4,38 +4,106 @@
 #include <iomanip>
 
 SymbolTable::SymbolTable()
-        : m_map{} {}
+        : m_entries{}, m_size{}, m_parent{nullptr} {}
 
-void SymbolTable::insert(std::string const &ident, Symbol::ptr symbol) {
-    m_map[ident] = std::move(symbol);
+void SymbolTable::insert(Interner::id_type ident, Symbol::ptr symbol) {
+    if (2 * (m_size + 1) > m_entries.size()) {
+        grow();
+    }
+
+    Entry &entry = m_entries[slot(ident)];
+    if (entry.ident == 0) {
+        entry.ident = ident;
+        m_size++;
+    }
+    entry.symbol = std::move(symbol);
 }
 
-Symbol::unowned_ptr SymbolTable::lookup(Token const &ident) const {
-    auto iter = m_map.find(ident.lexeme());
+Symbol::unowned_ptr SymbolTable::lookup(Interner::id_type ident) const {
+    if (m_entries.empty()) {
+        return nullptr;
+    }
 
-    if (iter == m_map.end()) {
+    Entry const &entry = m_entries[slot(ident)];
+    if (entry.ident != ident) {
         return nullptr;
     }
-    
-    return iter->second.get();
+
+    return entry.symbol.get();
+}
+
+Symbol::ptr SymbolTable::remove(Interner::id_type ident) {
+    if (m_entries.empty() || m_entries[slot(ident)].ident != ident) {
+        return nullptr;
+    }
+
+    std::size_t const mask = m_entries.size() - 1;
+    std::size_t hole = slot(ident);
+
+    Symbol::ptr symbol = std::move(m_entries[hole].symbol);
+    m_entries[hole].ident = 0;
+    m_size--;
+
+    /* Moves later entries of the probe sequence back, so that lookups never
+       stop at the hole before reaching them */
+    for (std::size_t i = (hole + 1) & mask; m_entries[i].ident != 0; 
+         i = (i + 1) & mask) {
+        std::size_t distance = (i - home(m_entries[i].ident)) & mask;
+
+        if (distance >= ((i - hole) & mask)) {
+            m_entries[hole] = std::move(m_entries[i]);
+            m_entries[i].ident = 0;
+            hole = i;
+        }
+    }
+
+    return symbol;
 }
 
-bool SymbolTable::defines(std::string const &ident) const {
-    return m_map.find(ident) != m_map.end();
+std::size_t SymbolTable::home(Interner::id_type ident) const {
+    std::size_t const mask = m_entries.size() - 1;
+    return static_cast<uint32_t>(ident * 0x9E3779B1u) & mask;
+}
+
+std::size_t SymbolTable::slot(Interner::id_type ident) const {
+    std::size_t const mask = m_entries.size() - 1;
+    std::size_t i = home(ident);
+
+    while (m_entries[i].ident != 0 && m_entries[i].ident != ident) {
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+void SymbolTable::grow() {
+    std::vector<Entry> old = std::move(m_entries);
+    m_entries = std::vector<Entry>(old.empty() ? 4 : 2 * old.size());
+
+    for (Entry &entry : old) {
+        if (entry.ident != 0) {
+            m_entries[slot(entry.ident)] = std::move(entry);
+        }
+    }
 }
 
 std::ostream &operator <<(std::ostream &stream, SymbolTable const &table) {
     stream << "{\n";
 
     bool first = true;
-    for (auto const &kv : table.m_map) {
+    for (auto const &entry : table.m_entries) {
+        if (entry.ident == 0) {
+            continue;
+        }
+
         if (first) {
             first = false;
         } else {
             stream << ",\n";
         }
 
-        stream << std::setw(2) << "" << kv.first << ": [" << *kv.second << "]";
+        stream << std::setw(2) << "" << Interner::lookup(entry.ident) 
+               << ": [" << *entry.symbol << "]";
     }
 
     stream << "\n}";
@@ -49,6 +117,13 @@ void SymbolScope::enter(SymbolTable &symbols) {
     m_tables.push_back(&symbols);
 }
 
+void SymbolScope::enter_nested(SymbolTable &symbols) {
+    if (symbols.parent()) {
+        enter_nested(*symbols.parent());
+    }
+    enter(symbols);
+}
+
 void SymbolScope::leave(SymbolTable &symbols) {
     if (&current() != &symbols) {
         throw FatalError(
@@ -106,7 +181,7 @@ void SymbolScope::declare(std::string const &ident, Symbol::ptr symbol) {
 }
 
 void SymbolScope::declare(Token const &ident, Symbol::ptr symbol) {
-    if (current().defines(ident.lexeme())) {
+    if (current().defines(ident.id())) {
         std::stringstream ss;
         ss << "`" << ident.lexeme() << "` was already declared in this scope";
         throw ParserError(ident.pos(), ss.str());
@@ -118,7 +193,7 @@ void SymbolScope::declare(Token const &ident, Symbol::ptr symbol) {
         throw ParserError(ident.pos(), ss.str());
     }
 
-    current().insert(ident.lexeme(), std::move(symbol));
+    current().insert(ident.id(), std::move(symbol));
 }
 
 FunctionDefinition &SymbolScope::declare_function(std::string const &ident, 
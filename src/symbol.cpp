@@ -1,4 +1,5 @@
 #include "symbol.hpp"
+#include <atomic>
 
 Symbol::Symbol()
         {}
@@ -21,16 +22,25 @@ BasicTypeSymbol::BasicTypeSymbol(Type::unowned_ptr type)
 DeclaredTypeSymbol::DeclaredTypeSymbol(Type::ptr type)  
         : TypeSymbol{}, m_type{std::move(type)} {}
 
-VariableSymbol::VariableSymbol(Type::unowned_ptr type)
-        : Symbol{}, m_type{type} {}
+VariableSymbol::VariableSymbol(Type::unowned_ptr type, bool is_global)
+        : Symbol{}, m_type{type},
+          m_is_array{dynamic_cast<ArrayType *>(type) != nullptr},
+          m_is_global{is_global} {}
 
 LocalVariableSymbol::LocalVariableSymbol(Type::unowned_ptr type)
-        : VariableSymbol{type}, m_offset{} {}
+        : VariableSymbol{type, false}, m_offset{} {}
 
 void LocalVariableSymbol::write(std::ostream &stream) const {
     stream << "LocalVariable: " << *m_type;
 }
 
+GlobalVariableSymbol::GlobalVariableSymbol(Type::unowned_ptr type, int id)
+        : VariableSymbol{type, true}, m_id{id} {}
+
+void GlobalVariableSymbol::write(std::ostream &stream) const {
+    stream << "GlobalVariable: " << *m_type;
+}
+
 FunctionSymbol::FunctionSymbol()
         : Symbol{}, m_definitions{} {}
 
@@ -54,15 +64,37 @@ void FunctionSymbol::add_definition(FunctionDefinition &&def) {
 
 FunctionDefinition::FunctionDefinition(FunctionType::ptr type, 
                                        ECallFunction ecall)
-        : m_type{std::move(type)}, m_def{ecall} {}
+        : m_id{next_id()}, m_type{std::move(type)}, m_def{ecall} {}
 
 FunctionDefinition::FunctionDefinition(FunctionType::ptr type, 
                                        FunctionDeclaration *decl,
                                        std::vector<LocalVariableSymbol::unowned_ptr> params,
                                        std::vector<LocalVariableSymbol::unowned_ptr> locals)
-        : m_type{std::move(type)}, m_def{decl}, 
+        : m_id{next_id()}, m_type{std::move(type)}, m_def{decl}, 
           m_params{params}, m_locals{locals} {}
 
+std::size_t FunctionDefinition::frame_size() const {
+    std::size_t words = 0;
+    for (LocalVariableSymbol::unowned_ptr local : m_locals) {
+        words += local->words();
+    }
+
+    return words;
+}
+
+void FunctionDefinition::rebind(FunctionDeclaration *decl,
+                                std::vector<LocalVariableSymbol::unowned_ptr> params,
+                                std::vector<LocalVariableSymbol::unowned_ptr> locals) {
+    m_def = decl;
+    m_params = std::move(params);
+    m_locals = std::move(locals);
+}
+
+int FunctionDefinition::next_id() {
+    static std::atomic<int> id{1};
+    return id++;
+}
+
 std::ostream &operator <<(std::ostream &stream, FunctionDefinition const &def) {
     stream << *def.m_type;
     return stream;
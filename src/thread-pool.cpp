@@ -0,0 +1,172 @@
+#include "thread-pool.hpp"
+#include <algorithm>
+#include <exception>
+
+namespace {
+
+/* The pool of the worker running on this thread, and its deque */
+thread_local ThreadPool const *t_pool = nullptr;
+
+thread_local std::size_t t_self = 0;
+
+}
+
+ThreadPool::ThreadPool(std::size_t threads)
+        : m_workers{}, m_threads{}, m_mutex{}, m_wake{}, m_done{},
+          m_queued{0}, m_stop{false} {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /* A single worker would only add hand-off latency, so parallel_for()
+       runs on the calling thread instead */
+    if (threads == 1) {
+        return;
+    }
+
+    for (std::size_t i = 0; i < threads; i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+
+    /* The first deque is served by the threads calling parallel_for() */
+    for (std::size_t i = 1; i < threads; i++) {
+        m_threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread &thread : m_threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::parallel_for(std::size_t n,
+                              std::function<void(std::size_t)> const &fn) {
+    std::vector<std::exception_ptr> errors(n);
+
+    if (m_threads.empty() || n <= 1) {
+        for (std::size_t i = 0; i < n; i++) {
+            try {
+                fn(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+                break;
+            }
+        }
+    } else {
+        std::size_t const workers = m_workers.size();
+
+        /* Counts the tasks of this call only, so that nested calls do not
+           wait for the task they are called from */
+        std::size_t pending = n;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queued += n;
+        }
+
+        for (std::size_t w = 0; w < workers; w++) {
+            Worker &worker = *m_workers[w];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+
+            /* Contiguous chunks keep related work on the same worker */
+            for (std::size_t i = w * n / workers;
+                 i < (w + 1) * n / workers; i++) {
+                worker.tasks.emplace_back([this, &fn, &errors, &pending, i]() {
+                    try {
+                        fn(i);
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (--pending == 0) {
+                        m_done.notify_all();
+                    }
+                });
+            }
+        }
+
+        m_wake.notify_all();
+
+        std::size_t const self = this->self();
+        Task task;
+        while (true) {
+            if (take(self, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+
+            /* The remaining tasks are running on other threads */
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (pending == 0) {
+                break;
+            }
+            m_done.wait(lock, [&pending]() { return pending == 0; });
+        }
+    }
+
+    for (std::exception_ptr const &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+void ThreadPool::run(std::size_t self) {
+    t_pool = this;
+    t_self = self;
+
+    Task task;
+
+    while (true) {
+        if (take(self, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [this]() { return m_stop || m_queued > 0; });
+
+        if (m_stop) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::take(std::size_t self, Task &task) {
+    std::size_t const workers = m_workers.size();
+
+    for (std::size_t i = 0; i < workers; i++) {
+        Worker &worker = *m_workers[(self + i) % workers];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+
+        if (worker.tasks.empty()) {
+            continue;
+        }
+
+        if (i == 0) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        } else {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        }
+        m_queued--;
+
+        return true;
+    }
+
+    return false;
+}
+
+std::size_t ThreadPool::self() const {
+    return t_pool == this ? t_self : 0;
+}
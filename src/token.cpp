@@ -18,6 +18,9 @@ std::unordered_map<TokenKind, std::string> const tokenkind_to_string_map = {
     { TokenKind::True, "True" },
     { TokenKind::False, "False" },
     { TokenKind::Null, "Null" },
+    { TokenKind::And, "and" },
+    { TokenKind::Or, "or" },
+    { TokenKind::Not, "not" },
 
     { TokenKind::Arrow, "->" },
     { TokenKind::Equals, "=" },
@@ -32,12 +35,18 @@ std::unordered_map<TokenKind, std::string> const tokenkind_to_string_map = {
     { TokenKind::Times, "*" },
     { TokenKind::FloorDiv, "//" },
     { TokenKind::Modulo, "%" },
+    { TokenKind::Ampersand, "&" },
+    { TokenKind::Pipe, "|" },
+    { TokenKind::Caret, "^" },
+    { TokenKind::Tilde, "~" },
+    { TokenKind::ShiftLeft, "<<" },
+    { TokenKind::ShiftRight, ">>" },
     { TokenKind::ParenLeft, "(" },
     { TokenKind::ParenRight, ")" },
     { TokenKind::BraceLeft, "{" },
     { TokenKind::BraceRight, "}" },
     { TokenKind::BracketLeft, "[" },
-    { TokenKind::BraceRight, "]" },
+    { TokenKind::BracketRight, "]" },
     { TokenKind::Comma, "," },
     { TokenKind::Semicolon, ";" },
     { TokenKind::Colon, ":" },
@@ -77,7 +86,11 @@ std::ostream &operator <<(std::ostream &stream, TokenKind kind) {
 
 Token::Token(TextPosition const &pos, TokenKind kind, 
              std::string const &&lexeme)
-        : m_pos{pos}, m_kind{kind}, m_lexeme{std::move(lexeme)} {}
+        : m_pos{pos}, m_kind{kind}, m_id{}, m_lexeme{std::move(lexeme)} {
+    if (m_kind == TokenKind::Identifier || m_kind == TokenKind::Synthetic) {
+        m_id = Interner::intern(m_lexeme);
+    }
+}
 
 Token const &Token::None() {
     static Token const none = Token();
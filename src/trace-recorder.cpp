@@ -0,0 +1,68 @@
+#include "trace-recorder.hpp"
+#include "error.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+TraceRecorder::TraceRecorder(std::string const &path)
+        : m_file{path, std::ios::binary | std::ios::trunc},
+          m_ring(Capacity), m_head{0}, m_tail{0}, m_tail_cache{0},
+          m_stalls{0}, m_done{false}, m_drainer{} {
+    if (!m_file) {
+        throw FatalError("Cannot open " + path);
+    }
+
+    m_file.write(Magic, sizeof(Magic));
+    write_binary<uint32_t>(m_file, Version);
+
+    m_drainer = std::thread(&TraceRecorder::drain, this);
+}
+
+TraceRecorder::~TraceRecorder() {
+    m_done.store(true, std::memory_order_release);
+    m_drainer.join();
+
+    if (!m_file.flush()) {
+        std::cerr << "Failed to write the trace" << std::endl;
+    }
+}
+
+void TraceRecorder::wait_for_space(std::size_t head) {
+    m_stalls++;
+
+    while ((m_tail_cache = m_tail.load(std::memory_order_acquire))
+            == head - Capacity) {
+        std::this_thread::yield();
+    }
+}
+
+void TraceRecorder::drain() {
+    std::size_t tail = 0;
+
+    for (;;) {
+        /* Read before the head, so that nothing written before the VM is
+           done is left behind */
+        bool done = m_done.load(std::memory_order_acquire);
+        std::size_t head = m_head.load(std::memory_order_acquire);
+
+        if (head == tail) {
+            if (done) {
+                return;
+            }
+
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+
+        /* Up to the end of the ring, the rest on the next round */
+        std::size_t begin = tail & (Capacity - 1);
+        std::size_t count = std::min(head - tail, Capacity - begin);
+
+        m_file.write(reinterpret_cast<char const *>(&m_ring[begin]),
+                     count * sizeof(Record));
+
+        tail += count;
+        m_tail.store(tail, std::memory_order_release);
+    }
+}
@@ -4,6 +4,9 @@
 #include <sstream>
 #include <string>
 
+TypeChecker::TypeChecker(ThreadPool &pool)
+        : m_pool{pool}, m_scope{}, m_curr_function{nullptr}, m_defs{} {}
+
 Node &TypeChecker::default_action(Node &node) {
     std::stringstream ss;
     ss << "TypeChecker(): unimplemented action: " << node.kind();
@@ -11,41 +14,57 @@ Node &TypeChecker::default_action(Node &node) {
 }
 
 Node &TypeChecker::visit(Program &program) {
-    m_scope.enter(program.symbols());
+    std::vector<FunctionDeclaration *> const &functions = program.functions();
 
-    for (Statement::ptr &stmt : program.stmts()) {
-        stmt->accept(*this);
-    }
+    /* Once symbols are resolved, function bodies no longer depend on each 
+       other, so they are checked independently of the top-level statements
+       and of each other */
+    m_pool.parallel_for(functions.size() + 1, [&](std::size_t i) {
+        TypeChecker checker(m_pool);
 
-    m_scope.leave(program.symbols());
+        if (i == 0) {
+            checker.check_main(program);
+        } else {
+            checker.check_function(*functions[i - 1]);
+        }
+    });
 
     return program;
 }
 
+void TypeChecker::check_functions(
+        std::vector<FunctionDeclaration *> const &functions) {
+    m_pool.parallel_for(functions.size(), [&](std::size_t i) {
+        TypeChecker checker(m_pool);
+        checker.check_function(*functions[i]);
+    });
+}
+
 Node &TypeChecker::visit(ParameterDeclaration &decl) {
     return decl;
 }
 
 Node &TypeChecker::visit(FunctionDeclaration &decl) {
-    FunctionDeclaration::unowned_ptr prev_func = m_curr_function;
-
-    m_curr_function = &decl;
-    m_scope.enter(decl.symbols());
-
-    for (Statement::ptr &stmt : decl.body()) {
-        stmt->accept(*this);
-    }
-
-    m_scope.leave(decl.symbols());
-    m_curr_function = prev_func;
-
+    /* Checked separately by visit(Program &) */
     return decl;
 }
 
 Node &TypeChecker::visit(VariableDeclaration &decl) {
+    bool is_array = dynamic_cast<ArrayType *>(decl.annotation()->type());
+
+    if (is_array && decl.value()) {
+        throw ParserError(decl.pos(), "Arrays cannot be initialized");
+    } else if (is_array) {
+        return decl;
+    } else if (!decl.value()) {
+        throw ParserError(decl.pos(), decl.ident().lexeme()
+                                      + " needs an initial value");
+    }
+
     decl.value()->accept(*this);
-    coerce_types(decl.value(), decl.annotation()->type(), 
-                 decl.pos(), "In initial value of " + decl.ident());
+    coerce_types(decl.value(), decl.annotation()->type(), decl.pos(), 
+                 [&]() { return "In initial value of " 
+                                + decl.ident().lexeme(); });
 
     return decl;
 }
@@ -68,17 +87,31 @@ Node &TypeChecker::visit(ExpressionStatement &stmt) {
 }
 
 Node &TypeChecker::visit(AssignStatement &stmt) {
+    /* Binds the symbol of a variable target */
     stmt.target()->accept(*this);
+
+    if (stmt.target()->kind() == NodeKind::Variable
+            && static_cast<Variable &>(*stmt.target()).symbol().is_array()) {
+        throw ParserError(stmt.pos(), "Cannot assign to an array");
+    }
+
     stmt.value()->accept(*this);
+
+    coerce_types(stmt.value(), stmt.target()->type(), stmt.value()->pos(),
+                 []() { return "In assignment"; });
+
     return stmt;
 }
 
 Node &TypeChecker::visit(ReturnStatement &stmt) {
+    if (!m_curr_function) {
+        throw ParserError(stmt.pos(), "Return outside of a function");
+    }
+
     stmt.value()->accept(*this);
 
-    std::stringstream ss;
     coerce_types(stmt.value(), m_curr_function->definition().type()->ret_type(), 
-                 stmt.pos(), ss.str());
+                 stmt.pos(), []() { return "In return statement"; });
                  
     return stmt;
 }
@@ -86,7 +119,7 @@ Node &TypeChecker::visit(ReturnStatement &stmt) {
 Node &TypeChecker::visit(IfElseStatement &stmt) {
     stmt.condition()->accept(*this);
     coerce_types(stmt.condition(), Type::BoolType(), stmt.condition()->pos(), 
-                 "In if-statement condition");
+                 []() { return "In if-statement condition"; });
 
     stmt.then_stmt()->accept(*this);
     stmt.else_stmt()->accept(*this);
@@ -97,7 +130,7 @@ Node &TypeChecker::visit(IfElseStatement &stmt) {
 Node &TypeChecker::visit(WhileStatement &stmt) {
     stmt.condition()->accept(*this);
     coerce_types(stmt.condition(), Type::BoolType(), stmt.condition()->pos(),
-                 "In while-statement condition");
+                 []() { return "In while-statement condition"; });
 
     stmt.loop_stmt()->accept(*this);
 
@@ -113,6 +146,30 @@ Node &TypeChecker::visit(ContinueStatement &stmt) {
 }
 
 Node &TypeChecker::visit(UnaryExpression &expr) {
+    expr.operand()->accept(*this);
+
+    auto context = [&]() {
+        return "On operation `" + expr.op().lexeme() + "`";
+    };
+
+    switch (expr.op().kind()) {
+        case TokenKind::Tilde:
+        case TokenKind::Minus:
+            coerce_types(expr.operand(), Type::IntType(),
+                         expr.operand()->pos(), context);
+            expr.set_type(Type::IntType());
+            break;
+
+        case TokenKind::Not:
+            coerce_types(expr.operand(), Type::BoolType(),
+                         expr.operand()->pos(), context);
+            expr.set_type(Type::BoolType());
+            break;
+
+        default:
+            throw FatalError("Unhandled operation: " + expr.op().lexeme());
+    }
+
     return expr;
 }
 
@@ -120,8 +177,9 @@ Node &TypeChecker::visit(BinaryExpression &expr) {
     expr.left()->accept(*this);
     expr.right()->accept(*this);
 
-    std::stringstream ss;
-    ss << "On operation `" << expr.op().lexeme() << "`";
+    auto context = [&]() { 
+        return "On operation `" + expr.op().lexeme() + "`"; 
+    };
 
     switch (expr.op().kind()) {
         case TokenKind::Plus:
@@ -129,10 +187,15 @@ Node &TypeChecker::visit(BinaryExpression &expr) {
         case TokenKind::Times:
         case TokenKind::FloorDiv:
         case TokenKind::Modulo:
+        case TokenKind::Ampersand:
+        case TokenKind::Pipe:
+        case TokenKind::Caret:
+        case TokenKind::ShiftLeft:
+        case TokenKind::ShiftRight:
             coerce_types(expr.left(), Type::IntType(), 
-                         expr.left()->pos(), ss.str());
+                         expr.left()->pos(), context);
             coerce_types(expr.right(), Type::IntType(), 
-                         expr.right()->pos(), ss.str());
+                         expr.right()->pos(), context);
             expr.set_type(Type::IntType());
             break;
 
@@ -143,9 +206,18 @@ Node &TypeChecker::visit(BinaryExpression &expr) {
         case TokenKind::GreaterThan:
         case TokenKind::GreaterEquals:
             coerce_types(expr.left(), Type::IntType(), 
-                         expr.left()->pos(), ss.str());
+                         expr.left()->pos(), context);
             coerce_types(expr.right(), Type::IntType(), 
-                         expr.right()->pos(), ss.str());
+                         expr.right()->pos(), context);
+            expr.set_type(Type::BoolType());
+            break;
+
+        case TokenKind::And:
+        case TokenKind::Or:
+            coerce_types(expr.left(), Type::BoolType(),
+                         expr.left()->pos(), context);
+            coerce_types(expr.right(), Type::BoolType(),
+                         expr.right()->pos(), context);
             expr.set_type(Type::BoolType());
             break;
 
@@ -156,13 +228,39 @@ Node &TypeChecker::visit(BinaryExpression &expr) {
     return expr;
 }
 
+Node &TypeChecker::visit(IndexExpression &expr) {
+    expr.base()->accept(*this);
+    expr.index()->accept(*this);
+
+    PointerType::unowned_ptr pointer
+            = dynamic_cast<PointerType *>(expr.base()->type());
+    if (!pointer || pointer->target() == Type::VoidType()) {
+        std::stringstream ss;
+        ss << "Cannot index a value of type `" << *expr.base()->type() << "`";
+        throw ParserError(expr.pos(), ss.str());
+    }
+
+    coerce_types(expr.index(), Type::IntType(), expr.index()->pos(),
+                 []() { return "In index"; });
+
+    /* Bytes and halves are loaded as ints */
+    Type::unowned_ptr target = pointer->target();
+    expr.set_width(target->size());
+    expr.set_type(target->size() < 4 ? Type::IntType() : target);
+
+    if (dynamic_cast<ArrayType *>(target)) {
+        throw ParserError(expr.pos(), "Cannot index pointers to arrays");
+    }
+
+    return expr;
+}
+
 Node &TypeChecker::visit(Call &expr) {
-    static std::vector<FunctionDefinition *> defs;
-    
     for (Expression::ptr &expr : expr.args()) {
         expr->accept(*this);
     }
     
+    std::vector<FunctionDefinition *> &defs = m_defs;
     defs.clear();
     m_scope.lookup_definitions(expr.func(), defs);
 
@@ -219,7 +317,8 @@ Node &TypeChecker::visit(Call &expr) {
 
     for (std::size_t i = 0; i < expr.args().size(); i++) {
         coerce_types(expr.args()[i], def->type()->param_types()[i], 
-                     expr.pos(), "In call to " + expr.func().lexeme());
+                     expr.pos(), 
+                     [&]() { return "In call to " + expr.func().lexeme(); });
     }
 
     expr.set_called(*def);
@@ -234,10 +333,17 @@ Node &TypeChecker::visit(Variable &expr) {
             = dynamic_cast<VariableSymbol *>(symbol);
 
     if (!var_symbol) {
-        throw ParserError(expr.pos(), expr.ident() + " is not a variable");
+        throw ParserError(expr.pos(), 
+                          expr.ident().lexeme() + " is not a variable");
     }
 
-    expr.set_type(var_symbol->type());
+    expr.set_symbol(*var_symbol);
+
+    /* Arrays are used through a pointer to their first element */
+    expr.set_type(var_symbol->is_array()
+            ? PointerType::Get(
+                    static_cast<ArrayType *>(var_symbol->type())->target())
+            : var_symbol->type());
     return expr;
 }
 
@@ -251,10 +357,30 @@ Node &TypeChecker::visit(BooleanLiteral &expr) {
     return expr;
 }
 
+void TypeChecker::check_main(Program &program) {
+    m_scope.enter(program.symbols());
+
+    for (Statement::ptr &stmt : program.stmts()) {
+        stmt->accept(*this);
+    }
+
+    m_scope.leave(program.symbols());
+}
+
+void TypeChecker::check_function(FunctionDeclaration &decl) {
+    m_curr_function = &decl;
+    m_scope.enter_nested(decl.symbols());
+
+    for (Statement::ptr &stmt : decl.body()) {
+        stmt->accept(*this);
+    }
+}
+
+template <typename Context>
 void TypeChecker::coerce_types(Expression::ptr &target, 
                                Type::unowned_ptr expected, 
                                TextPosition const &pos,
-                               std::string const &context) {
+                               Context const &context) {
     if (target->type() == expected) { // TODO FIXME works for now but fix
         return;
     }
@@ -264,8 +390,14 @@ void TypeChecker::coerce_types(Expression::ptr &target,
         return;
     }
 
+    /* Pointers are byte addresses, which may be computed as ints */
+    if (target->type() == Type::IntType()
+            && dynamic_cast<PointerType *>(expected)) {
+        return;
+    }
+
     std::stringstream ss;
-    ss << context << ": cannot use value of type `" << *target->type() 
+    ss << context() << ": cannot use value of type `" << *target->type() 
        << "` as `" << *expected << "`";
     throw ParserError(pos, ss.str());
 }
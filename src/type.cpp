@@ -1,4 +1,7 @@
 #include "type.hpp"
+#include <map>
+#include <mutex>
+#include <unordered_map>
 
 Type::Type()
         {}    
@@ -19,7 +22,17 @@ Type::unowned_ptr Type::WordType() {
 }
 
 Type::unowned_ptr Type::VoidType() {
-    static NamedType type("void");
+    static NamedType type("void", 0);
+    return &type;
+}
+
+Type::unowned_ptr Type::ByteType() {
+    static NamedType type("byte", 1);
+    return &type;
+}
+
+Type::unowned_ptr Type::HalfType() {
+    static NamedType type("half", 2);
     return &type;
 }
 
@@ -28,27 +41,87 @@ std::ostream &operator <<(std::ostream &stream, Type const &type) {
     return stream;
 }
 
-NamedType::NamedType(std::string const &name)
-        : m_name{name} {}
+NamedType::NamedType(std::string const &name, std::size_t size)
+        : m_name{name}, m_size{size} {}
 
-JSONObject::ptr NamedType::to_json() const {
-    JSONObject::ptr object = std::make_unique<JSONObject>();
-    object->add_key("name", std::make_unique<JSONString>(m_name));
-    return object;
+void NamedType::write_json(JSONWriter &writer) const {
+    writer.begin_object();
+    writer.field("name", m_name);
+    writer.end_object();
 }
 
 void NamedType::write(std::ostream &stream) const {
     stream << m_name;
 }
 
+PointerType::PointerType(Type::unowned_ptr target)
+        : m_target{target} {}
+
+Type::unowned_ptr PointerType::Get(Type::unowned_ptr target) {
+    static std::mutex mutex;
+    static std::unordered_map<Type::unowned_ptr, PointerType::ptr> types;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    PointerType::ptr &type = types[target];
+    if (!type) {
+        type.reset(new PointerType(target));
+    }
+
+    return type.get();
+}
+
+void PointerType::write_json(JSONWriter &writer) const {
+    writer.begin_object();
+    writer.key("pointer-to");
+    m_target->write_json(writer);
+    writer.end_object();
+}
+
+void PointerType::write(std::ostream &stream) const {
+    stream << "*" << *m_target;
+}
+
+ArrayType::ArrayType(Type::unowned_ptr target, std::size_t length)
+        : m_target{target}, m_length{length} {}
+
+Type::unowned_ptr ArrayType::Get(Type::unowned_ptr target,
+                                 std::size_t length) {
+    static std::mutex mutex;
+    static std::map<std::pair<Type::unowned_ptr, std::size_t>,
+                    ArrayType::ptr> types;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    ArrayType::ptr &type = types[{ target, length }];
+    if (!type) {
+        type.reset(new ArrayType(target, length));
+    }
+
+    return type.get();
+}
+
+void ArrayType::write_json(JSONWriter &writer) const {
+    writer.begin_object();
+    writer.key("array-of");
+    m_target->write_json(writer);
+    writer.field("length", m_length);
+    writer.end_object();
+}
+
+void ArrayType::write(std::ostream &stream) const {
+    stream << *m_target << "[" << m_length << "]";
+}
+
 FunctionType::FunctionType(std::vector<Type::unowned_ptr> params, 
                            Type::unowned_ptr ret_type)
         : m_param_types{params}, m_ret_type{ret_type} {}
 
-JSONObject::ptr FunctionType::to_json() const {
-    JSONObject::ptr object = std::make_unique<JSONObject>();
-    object->add_key("return-type", m_ret_type->to_json());
-    return object;
+void FunctionType::write_json(JSONWriter &writer) const {
+    writer.begin_object();
+    writer.key("return-type");
+    m_ret_type->write_json(writer);
+    writer.end_object();
 }
 
 void FunctionType::write(std::ostream &stream) const {
@@ -1,13 +1,39 @@
 #include "virtual-machine.hpp"
 #include "instruction.hpp"
+#include "opcode-histogram.hpp"
+#include "trace-recorder.hpp"
+#include "sample-profiler.hpp"
+#include "error.hpp"
+#include "utils.hpp"
 #include <iomanip>
-
-VirtualMachine::VirtualMachine(Memory &memory)
-        : m_memory{memory}, 
-          m_ip{0}, m_base{133}, m_terminated{false} {
+#include <sstream>
+#include <cstring>
+
+VirtualMachine::VirtualMachine(Memory &memory, Output &output)
+        : m_no_observer{}, m_memory{memory}, m_output{output},
+          m_host_functions{HostFunctions::registry().functions()},
+          m_inputs{0}, m_steps{0},
+          m_ip{0}, m_base{133}, m_terminated{false},
+          m_stopped{false}, m_breaks{false} {
     m_memory.set_top(memory.size());
 }
 
+void VirtualMachine::inject(std::vector<uint32_t> const &values) {
+    if (4 * values.size() > m_memory.size()) {
+        throw FatalError("inject(): more inputs than fit in memory");
+    }
+
+    m_inputs = values.size();
+
+    std::size_t addr = m_memory.size() - 4 * m_inputs;
+    m_memory.set_top(addr);
+
+    for (uint32_t value : values) {
+        m_memory.set_word(value, addr);
+        addr += 4;
+    }
+}
+
 void VirtualMachine::execute_quantum(int q) {
     if (m_terminated) {
         return;
@@ -18,28 +44,30 @@ void VirtualMachine::execute_quantum(int q) {
     }
 }
 
-void VirtualMachine::execute_step() {
+template <typename Observer>
+void VirtualMachine::execute_step(Observer &observer) {
     if (m_terminated) {
         return;
     }
 
+    m_steps++;
+
     uint32_t assembled = m_memory.get_word(m_ip);
 
     OpCode opcode = Instruction::unpack_opcode(assembled);
     uint32_t data = Instruction::unpack_data(assembled);
 
+    observer.on_step(m_ip, m_memory.top(), assembled);
+
     uint32_t x, y, addr;
     int32_t sx = x, sy = y;
 
-    // std::cout << std::left << std::setw(8) << m_ip
-    //           << Instruction::Disassemble(assembled) << std::endl;
-
     switch (opcode) {
         case OpCode::Nop:
             break;
 
         case OpCode::ECall:
-            execute_ecall(static_cast<ECallFunction>(data));
+            execute_ecall(data);
             break;
 
         case OpCode::Call:
@@ -94,7 +122,7 @@ void VirtualMachine::execute_step() {
             break;
 
         case OpCode::LoadAbs:
-            x = m_memory.get_word(data);
+            x = m_memory.get_word(4 * data);
             m_memory.push_word(x);
             break;
 
@@ -106,7 +134,7 @@ void VirtualMachine::execute_step() {
 
         case OpCode::StoreAbs:
             x = m_memory.pop_word();
-            m_memory.set_word(x, data);
+            m_memory.set_word(x, 4 * data);
             break;
 
         case OpCode::Enter:
@@ -178,30 +206,211 @@ void VirtualMachine::execute_step() {
             x = m_memory.pop_word();
             m_memory.push_word(x != y);
             break;
-    }
 
-    m_ip += 4;
-}
+        case OpCode::LoadByte:
+            y = m_memory.pop_word();
+            addr = m_memory.pop_word();
+            m_memory.push_word(m_memory.get_byte(addr + y));
+            break;
+
+        case OpCode::LoadHalf:
+            y = m_memory.pop_word();
+            addr = m_memory.pop_word();
+            m_memory.push_word(m_memory.get_half(addr + 2 * y));
+            break;
+
+        case OpCode::LoadWord:
+            y = m_memory.pop_word();
+            addr = m_memory.pop_word();
+            m_memory.push_word(m_memory.get_word(addr + 4 * y));
+            break;
+
+        case OpCode::StoreByte:
+            x = m_memory.pop_word();
+            y = m_memory.pop_word();
+            addr = m_memory.pop_word();
+            m_memory.set_byte(x, addr + y);
+            break;
+
+        case OpCode::StoreHalf:
+            x = m_memory.pop_word();
+            y = m_memory.pop_word();
+            addr = m_memory.pop_word();
+            m_memory.set_half(x, addr + 2 * y);
+            break;
+
+        case OpCode::StoreWord:
+            x = m_memory.pop_word();
+            y = m_memory.pop_word();
+            addr = m_memory.pop_word();
+            m_memory.set_word(x, addr + 4 * y);
+            break;
+
+        case OpCode::LoadIdxRel:
+            y = m_memory.pop_word();
+            addr = m_base + Instruction::sign_extend_24_32(data) + 4 * y;
+            m_memory.push_word(m_memory.get_word(addr));
+            break;
+
+        case OpCode::StoreIdxRel:
+            x = m_memory.pop_word();
+            y = m_memory.pop_word();
+            addr = m_base + Instruction::sign_extend_24_32(data) + 4 * y;
+            m_memory.set_word(x, addr);
+            break;
+
+        case OpCode::AddrRel:
+            m_memory.push_word(m_base + Instruction::sign_extend_24_32(data));
+            break;
+
+        case OpCode::LoadIdxAbs:
+            y = m_memory.pop_word();
+            m_memory.push_word(m_memory.get_word(4 * (data + y)));
+            break;
+
+        case OpCode::StoreIdxAbs:
+            x = m_memory.pop_word();
+            y = m_memory.pop_word();
+            m_memory.set_word(x, 4 * (data + y));
+            break;
+
+        case OpCode::AddrAbs:
+            m_memory.push_word(4 * data);
+            break;
+
+        case OpCode::IAnd:
+            y = m_memory.pop_word();
+            x = m_memory.pop_word();
+            m_memory.push_word(x & y);
+            break;
+
+        case OpCode::IOr:
+            y = m_memory.pop_word();
+            x = m_memory.pop_word();
+            m_memory.push_word(x | y);
+            break;
 
-void VirtualMachine::execute_ecall(ECallFunction ecall) {
-    switch (ecall) {
-        case ECallFunction::None:
+        case OpCode::IXor:
+            y = m_memory.pop_word();
+            x = m_memory.pop_word();
+            m_memory.push_word(x ^ y);
             break;
 
-        case ECallFunction::PrintInt:
-            std::cout << ">> " << m_memory.pop_word() << std::endl;
-            m_memory.push_word(0);
+        case OpCode::INot:
+            x = m_memory.pop_word();
+            m_memory.push_word(~x);
             break;
 
-        case ECallFunction::PrintBool:
-            std::cout << ">> " << (m_memory.pop_word() ? "True" : "False")
-                      << std::endl;
-            m_memory.push_word(0);
+        case OpCode::IShl:
+            y = m_memory.pop_word();
+            x = m_memory.pop_word();
+            m_memory.push_word(x << (y & 31));
             break;
 
-        case ECallFunction::Exit:
-            m_terminated = true;
+        case OpCode::IShr:
+            y = m_memory.pop_word();
+            sx = m_memory.pop_word();
+            m_memory.push_word(sx >> (y & 31));
             break;
+
+        case OpCode::INeg:
+            x = m_memory.pop_word();
+            m_memory.push_word(0 - x);
+            break;
+
+        /* Not a step, and the ip stays at the Break */
+        case OpCode::Break:
+            if (!m_breaks) {
+                std::stringstream ss;
+                ss << "Break instruction at " << m_ip
+                   << " without a debugger";
+                throw FatalError(ss.str());
+            }
+
+            m_steps--;
+            m_stopped = m_terminated = true;
+            return;
+    }
+
+    m_ip += 4;
+}
+
+template void VirtualMachine::execute_step(NoObserver &observer);
+
+template void VirtualMachine::execute_step(OpcodeHistogram &observer);
+
+template void VirtualMachine::execute_step(TraceRecorder &observer);
+
+template void VirtualMachine::execute_step(SampleProfiler &observer);
+
+void VirtualMachine::save(std::ostream &stream) const {
+    stream.write(SnapshotMagic, sizeof(SnapshotMagic));
+    write_binary<uint32_t>(stream, SnapshotVersion);
+
+    write_binary<uint64_t>(stream, m_ip);
+    write_binary<uint64_t>(stream, m_base);
+    write_binary<uint8_t>(stream, m_terminated);
+    write_binary<uint64_t>(stream, m_inputs);
+
+    m_memory.save(stream);
+}
+
+void VirtualMachine::load(std::istream &stream) {
+    char magic[sizeof(SnapshotMagic)];
+    if (!stream.read(magic, sizeof(magic))
+            || std::memcmp(magic, SnapshotMagic, sizeof(magic)) != 0) {
+        throw FatalError("load(): not a pix snapshot");
+    }
+
+    if (read_binary<uint32_t>(stream) != SnapshotVersion) {
+        throw FatalError("load(): unsupported snapshot version");
+    }
+
+    m_ip = read_binary<uint64_t>(stream);
+    m_base = read_binary<uint64_t>(stream);
+    m_terminated = read_binary<uint8_t>(stream);
+    m_inputs = read_binary<uint64_t>(stream);
+
+    m_memory.load(stream);
+}
+
+uint32_t VirtualMachine::input(std::size_t i) const {
+    if (i >= m_inputs) {
+        return 0;
+    }
+
+    return m_memory.get_word(m_memory.size() - 4 * (m_inputs - i));
+}
+
+void VirtualMachine::resume() {
+    if (m_stopped) {
+        m_stopped = m_terminated = false;
+    }
+}
+
+void VirtualMachine::terminate() {
+    m_terminated = true;
+    m_output.flush();
+}
+
+void VirtualMachine::execute_ecall(uint32_t index) {
+    if (index >= m_host_functions.size()) {
+        std::stringstream ss;
+        ss << "Unknown host function: " << index;
+        throw FatalError(ss.str());
+    }
+
+    HostFunctions::Function const &function = m_host_functions[index];
+
+    /* Arguments were pushed in order, so the last one is on top */
+    uint32_t args[HostFunctions::MaxParams];
+    for (std::size_t i = function.params.size(); i-- > 0; ) {
+        args[i] = m_memory.pop_word();
+    }
+
+    uint32_t result = function.callback(*this, args);
+    if (function.pushes_result) {
+        m_memory.push_word(result);
     }
 }
 
@@ -25,6 +25,14 @@ Node &AstVisitor::visit(NamedTypeAnnotation &anno) {
     return default_action(anno);
 }
 
+Node &AstVisitor::visit(PointerTypeAnnotation &anno) {
+    return default_action(anno);
+}
+
+Node &AstVisitor::visit(ArrayTypeAnnotation &anno) {
+    return default_action(anno);
+}
+
 Node &AstVisitor::visit(ScopedBlockStatement &stmt) {
     return default_action(stmt);
 }
@@ -65,6 +73,10 @@ Node &AstVisitor::visit(BinaryExpression &expr) {
     return default_action(expr);
 }
 
+Node &AstVisitor::visit(IndexExpression &expr) {
+    return default_action(expr);
+}
+
 Node &AstVisitor::visit(Call &expr) {
     return default_action(expr);
 }
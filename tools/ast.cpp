@@ -0,0 +1,61 @@
+#include "ast-serializer.hpp"
+#include "code-generator.hpp"
+#include "thread-pool.hpp"
+#include "options.hpp"
+#include "error.hpp"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+/* Prints an AST written by pix --ast-cache, as JSON like --debug-ast, or
+   with --code the code generated from it, like --debug-code.
+
+   usage: ast [--code] file */
+
+int main(int argc, char *argv[]) {
+    std::string path;
+    bool code = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--code") {
+            code = true;
+        } else if (path.empty()) {
+            path = arg;
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (path.empty()) {
+        std::cerr << "usage: ast [--code] file" << std::endl;
+        return 1;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return 1;
+    }
+
+    try {
+        Program::ptr program = AstDeserializer(file).read();
+
+        if (code) {
+            ThreadPool pool;
+            std::cout << CodeGenerator(pool).generate(*program) << std::endl;
+        } else {
+            options.json.spacing = 2;
+            JSONWriter writer(std::cout);
+            program->write_json(writer);
+            std::cout << std::endl;
+        }
+    } catch (FatalError const &e) {
+        std::cerr << path << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
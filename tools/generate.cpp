@@ -0,0 +1,353 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* Writes a valid pix program of configurable size and shape, for testing
+   the compiler at scale. Every function has overloads that differ in the
+   type of their second parameter, locals of every type, nested control
+   flow, a nested function, and calls to functions further down, passing
+   on a budget that bounds the depth of the calls at run time.
+
+   usage: generate [--functions n] [--overloads n] [--depth n] [--locals n]
+                   [--globals n] [--shape chain|tree|random] [--fanout n]
+                   [--calls n] [--seed n] [-o path]
+
+   Large programs need more memory than the default to run, e.g. with
+   --mem-width 1024 --mem-height 1024. */
+
+class Generator {
+public:
+    struct Options {
+        int functions = 100;
+
+        /* Between 1 and the number of parameter types */
+        int overloads = 2;
+
+        /* Nesting of ifs, loops and blocks in every function */
+        int depth = 2;
+
+        int locals = 4;
+
+        int globals = 4;
+
+        std::string shape = "random";
+
+        /* Callees of every function for the random shape */
+        int fanout = 2;
+
+        /* Depth of the calls at run time */
+        int calls = 6;
+
+        unsigned seed = 1;
+    };
+
+    Generator(Options const &options);
+
+    std::string generate();
+
+    static constexpr int ParamTypes = 5;
+
+private:
+    void write_function(int id, int overload);
+
+    void write_block(int depth, int n);
+
+    void write_statement(int depth, int n);
+
+    /* An int expression of the locals declared so far */
+    std::string expression();
+
+    /* A call of some overload of callee, which adds to v0 */
+    std::string call(int callee);
+
+    std::vector<int> callees(int id);
+
+    int random(int n)
+            { return std::uniform_int_distribution<>(0, n - 1)(m_rng); }
+
+    std::ostream &indent(int n) { return m_out << std::string(4 * n, ' '); }
+
+    static char const *const Types[ParamTypes];
+
+    Options m_options;
+
+    std::mt19937 m_rng;
+
+    std::stringstream m_out;
+
+    /* Names of the int locals in scope, and a counter for fresh names */
+    std::vector<std::string> m_ints;
+
+    int m_fresh;
+};
+
+char const *const Generator::Types[ParamTypes] = {
+    "int", "bool", "*int", "*byte", "word"
+};
+
+Generator::Generator(Options const &options)
+        : m_options{options}, m_rng{options.seed}, m_out{}, m_ints{},
+          m_fresh{0} {}
+
+std::string Generator::generate() {
+    for (int k = 0; k < m_options.globals; k++) {
+        m_out << "g" << k << ": int = " << k << ";\n";
+    }
+    m_out << "table: int[16];\n\n";
+
+    for (int id = 0; id < m_options.functions; id++) {
+        for (int overload = 0; overload < m_options.overloads; overload++) {
+            write_function(id, overload);
+        }
+    }
+
+    m_out << "print(f0(" << m_options.calls << ", 1));\n"
+          << "print(table[" << m_options.functions % 16 << "]);\n";
+
+    return m_out.str();
+}
+
+void Generator::write_function(int id, int overload) {
+    m_ints = { "d" };
+    m_fresh = 0;
+
+    m_out << "function f" << id << "(d: int, x: " << Types[overload]
+          << ") -> int {\n";
+
+    indent(1) << "function twice(y: int) -> int {\n";
+    indent(2) << "return y + y;\n";
+    indent(1) << "}\n\n";
+
+    indent(1) << "a: int[8];\n";
+    indent(1) << "buf: byte[16];\n";
+    indent(1) << "w: word = d;\n";
+    indent(1) << "v0: int = d * 3 + " << id << ";\n";
+    m_ints.push_back("v0");
+
+    for (int k = 1; k < m_options.locals; k++) {
+        std::string name = "v" + std::to_string(k);
+        indent(1) << name << ": int = " << expression() << ";\n";
+        m_ints.push_back(name);
+    }
+
+    switch (overload) {
+        case 0:
+        case 4:
+            indent(1) << "v0 = v0 + x;\n";
+            break;
+
+        case 1:
+            indent(1) << "if x {\n";
+            indent(2) << "v0 = v0 + 1;\n";
+            indent(1) << "}\n";
+            break;
+
+        case 2:
+            indent(1) << "x[d & 7] = v0;\n";
+            indent(1) << "v0 = v0 + x[1];\n";
+            break;
+
+        case 3:
+            indent(1) << "x[d & 15] = v0 & 255;\n";
+            indent(1) << "v0 = v0 + x[3];\n";
+            break;
+    }
+
+    write_block(m_options.depth, 1);
+
+    for (int callee : callees(id)) {
+        indent(1) << "if d > 0 {\n";
+        indent(2) << call(callee) << "\n";
+        indent(1) << "}\n";
+    }
+
+    if (m_options.globals > 0) {
+        std::string global = "g" + std::to_string(random(m_options.globals));
+        indent(1) << global << " = (" << global << " + v0) & 255;\n";
+    }
+    indent(1) << "table[" << id % 16 << "] = table[" << id % 16
+              << "] ^ v0;\n";
+    indent(1) << "return twice(v0) & 65535;\n";
+    m_out << "}\n\n";
+}
+
+void Generator::write_block(int depth, int n) {
+    std::size_t scope = m_ints.size();
+
+    write_statement(0, n);
+    if (depth > 0) {
+        write_statement(depth, n);
+    }
+
+    m_ints.resize(scope);
+}
+
+void Generator::write_statement(int depth, int n) {
+    std::string target = m_ints[1 + random(m_ints.size() - 1)];
+
+    if (depth == 0) {
+        indent(n) << target << " = " << expression() << ";\n";
+        return;
+    }
+
+    std::string name = "t" + std::to_string(m_fresh++);
+
+    switch (random(3)) {
+        case 0:
+            indent(n) << "if " << expression() << " > "
+                      << expression() << " and not (v0 == 7) {\n";
+            write_block(depth - 1, n + 1);
+            indent(n) << "} else {\n";
+            write_block(depth - 1, n + 1);
+            indent(n) << "}\n";
+            break;
+
+        case 1:
+            indent(n) << name << ": int = 0;\n";
+            indent(n) << "while " << name << " < 3 or v0 < 0 {\n";
+            indent(n + 1) << name << " = " << name << " + 1;\n";
+            indent(n + 1) << "if " << name << " == 2 {\n";
+            indent(n + 2) << "continue;\n";
+            indent(n + 1) << "}\n";
+            indent(n + 1) << "if " << name << " > 5 {\n";
+            indent(n + 2) << "break;\n";
+            indent(n + 1) << "}\n";
+            write_block(depth - 1, n + 1);
+            indent(n) << "}\n";
+            m_ints.push_back(name);
+            break;
+
+        case 2:
+            indent(n) << "{\n";
+            indent(n + 1) << name << ": int = " << expression() << ";\n";
+            m_ints.push_back(name);
+            write_block(depth - 1, n + 1);
+            m_ints.pop_back();
+            indent(n + 1) << "v0 = v0 + " << name << ";\n";
+            indent(n) << "}\n";
+            break;
+    }
+}
+
+std::string Generator::expression() {
+    std::string left = m_ints[random(m_ints.size())];
+    std::string right = m_ints[random(m_ints.size())];
+
+    /* Divisors are odd, so never zero */
+    switch (random(10)) {
+        case 0:
+            return left + " + " + right;
+        case 1:
+            return left + " - " + std::to_string(random(100));
+        case 2:
+            return left + " * " + std::to_string(random(9) + 1);
+        case 3:
+            return left + " // (" + right + " | 1)";
+        case 4:
+            return left + " % (" + right + " | 1)";
+        case 5:
+            return "(" + left + " & 255) << 2";
+        case 6:
+            return left + " >> " + std::to_string(random(8));
+        case 7:
+            return left + " ^ " + right + " | " + std::to_string(random(16));
+        case 8:
+            return "(-" + left + ") + (~" + right + ")";
+        default:
+            return "a[" + left + " & 7] + buf[" + right + " & 15]";
+    }
+}
+
+std::string Generator::call(int callee) {
+    int overload = random(m_options.overloads);
+    std::string args[ParamTypes] = { "v0", "v0 < 5", "a", "buf", "w" };
+
+    return "v0 = v0 + f" + std::to_string(callee) + "(d - 1, "
+           + args[overload] + ");";
+}
+
+std::vector<int> Generator::callees(int id) {
+    std::vector<int> result;
+    int n = m_options.functions;
+
+    if (m_options.shape == "chain") {
+        if (id + 1 < n) {
+            result.push_back(id + 1);
+        }
+    } else if (m_options.shape == "tree") {
+        for (int child = 2 * id + 1; child <= 2 * id + 2 && child < n;
+                child++) {
+            result.push_back(child);
+        }
+    } else {
+        for (int k = 0; k < m_options.fanout && id + 1 < n; k++) {
+            result.push_back(id + 1 + random(n - id - 1));
+        }
+    }
+
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    Generator::Options options;
+    std::string path;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--functions") {
+            options.functions = std::stoi(value);
+        } else if (arg == "--overloads") {
+            options.overloads = std::stoi(value);
+        } else if (arg == "--depth") {
+            options.depth = std::stoi(value);
+        } else if (arg == "--locals") {
+            options.locals = std::stoi(value);
+        } else if (arg == "--globals") {
+            options.globals = std::stoi(value);
+        } else if (arg == "--shape") {
+            options.shape = value;
+        } else if (arg == "--fanout") {
+            options.fanout = std::stoi(value);
+        } else if (arg == "--calls") {
+            options.calls = std::stoi(value);
+        } else if (arg == "--seed") {
+            options.seed = std::stoul(value);
+        } else if (arg == "-o") {
+            path = value;
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.functions < 1 || options.overloads < 1
+            || options.overloads > Generator::ParamTypes
+            || options.depth < 0 || options.locals < 1
+            || options.globals < 0 || options.fanout < 0
+            || (options.shape != "chain" && options.shape != "tree"
+                && options.shape != "random")) {
+        std::cerr << "Invalid options" << std::endl;
+        return 1;
+    }
+
+    std::string program = Generator(options).generate();
+
+    if (path.empty()) {
+        std::cout << program;
+    } else if (!(std::ofstream(path) << program)) {
+        std::cerr << "Cannot write " << path << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
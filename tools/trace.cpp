@@ -0,0 +1,190 @@
+#include "trace-recorder.hpp"
+#include "instruction.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* Disassembles and summarizes a trace written by pix --trace: how often
+   every opcode and every instruction ran, and how deep the stack got.
+
+   usage: trace [--dump n] [--top n] file
+
+   --dump prints the first n records, 0 for all of them. */
+
+using Record = TraceRecorder::Record;
+
+struct Summary {
+    uint64_t records = 0;
+
+    std::unordered_map<uint32_t, uint64_t> opcodes;
+
+    /* Executions of every ip, with the instruction found there last */
+    std::unordered_map<uint32_t, std::pair<uint64_t, uint32_t>> ips;
+
+    uint32_t lowest_top = UINT32_MAX;
+
+    uint32_t highest_top = 0;
+};
+
+static void print_record(Record const &record) {
+    std::cout << std::setw(10) << record.ip << std::setw(10) << record.top
+              << "  " << Instruction::Disassemble(record.instruction)
+              << std::endl;
+}
+
+/* The n largest counts, most frequent first */
+template <typename Map>
+static std::vector<std::pair<uint32_t, uint64_t>> top_counts(
+        Map const &map, std::size_t n,
+        uint64_t (*count)(typename Map::mapped_type const &)) {
+    std::vector<std::pair<uint32_t, uint64_t>> counts;
+    for (auto const &[key, value] : map) {
+        counts.emplace_back(key, count(value));
+    }
+
+    std::sort(counts.begin(), counts.end(),
+            [](auto const &a, auto const &b) {
+                return a.second != b.second ? a.second > b.second
+                                            : a.first < b.first;
+            });
+
+    counts.resize(std::min(n, counts.size()));
+    return counts;
+}
+
+static void print_summary(Summary const &summary, std::size_t top) {
+    std::cout << "records: " << summary.records << std::endl;
+    if (summary.records == 0) {
+        return;
+    }
+
+    std::cout << "stack top: " << summary.lowest_top << " to "
+              << summary.highest_top << " ("
+              << summary.highest_top - summary.lowest_top << " bytes)"
+              << std::endl;
+
+    std::cout << std::endl << "opcodes:" << std::endl;
+    for (auto const &[opcode, count] : top_counts(summary.opcodes, SIZE_MAX,
+            [](uint64_t const &count) { return count; })) {
+        std::cout << std::setw(12) << count << std::setw(8) << std::fixed
+                  << std::setprecision(2) << 100.0 * count / summary.records
+                  << "%  " << static_cast<OpCode>(opcode) << std::endl;
+    }
+
+    std::cout << std::endl << "instructions:" << std::endl;
+    for (auto const &[ip, count] : top_counts(summary.ips, top,
+            [](std::pair<uint64_t, uint32_t> const &value) {
+                return value.first;
+            })) {
+        std::cout << std::setw(12) << count << std::setw(8) << std::fixed
+                  << std::setprecision(2) << 100.0 * count / summary.records
+                  << "%" << std::setw(10) << ip << "  "
+                  << Instruction::Disassemble(summary.ips.at(ip).second)
+                  << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string path;
+    bool dump = false;
+    uint64_t dump_count = 0;
+    std::size_t top = 20;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--dump" && i + 1 < argc) {
+            dump = true;
+            dump_count = std::stoull(argv[++i]);
+        } else if (arg == "--top" && i + 1 < argc) {
+            top = std::stoul(argv[++i]);
+        } else if (path.empty()) {
+            path = arg;
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if (path.empty()) {
+        std::cerr << "usage: trace [--dump n] [--top n] file" << std::endl;
+        return 1;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return 1;
+    }
+
+    char magic[sizeof(TraceRecorder::Magic)];
+    uint32_t version;
+    if (!file.read(magic, sizeof(magic))
+            || std::memcmp(magic, TraceRecorder::Magic, sizeof(magic)) != 0
+            || !file.read(reinterpret_cast<char *>(&version), sizeof(version))
+            || version != TraceRecorder::Version) {
+        std::cerr << path << " is not a pix trace" << std::endl;
+        return 1;
+    }
+
+    if (dump) {
+        std::cout << std::setw(10) << "ip" << std::setw(10) << "top"
+                  << "  instruction" << std::endl;
+    }
+
+    Summary summary;
+    std::vector<Record> chunk(1 << 16);
+
+    /* Bytes after the last whole record, which the read returning nothing
+       does not tell */
+    std::size_t remainder = 0;
+
+    for (;;) {
+        file.read(reinterpret_cast<char *>(chunk.data()),
+                  chunk.size() * sizeof(Record));
+
+        std::size_t count = file.gcount() / sizeof(Record);
+        if (file.gcount() > 0) {
+            remainder = file.gcount() % sizeof(Record);
+        }
+        if (count == 0) {
+            break;
+        }
+
+        for (std::size_t i = 0; i < count; i++) {
+            Record const &record = chunk[i];
+
+            if (dump && (dump_count == 0 || summary.records < dump_count)) {
+                print_record(record);
+            }
+
+            summary.records++;
+            summary.opcodes[record.instruction & 0xFF]++;
+
+            auto &ip = summary.ips[record.ip];
+            ip.first++;
+            ip.second = record.instruction;
+
+            summary.lowest_top = std::min(summary.lowest_top, record.top);
+            summary.highest_top = std::max(summary.highest_top, record.top);
+        }
+    }
+
+    if (remainder != 0) {
+        std::cerr << "Warning: " << path << " ends in a partial record"
+                  << std::endl;
+    }
+
+    if (dump) {
+        std::cout << std::endl;
+    }
+    print_summary(summary, top);
+
+    return 0;
+}